@@ -0,0 +1,75 @@
+#include "Block.h"
+#include "WorkerPool.h"
+#include <string>
+
+// Below this many hashes per level the work is done on the calling thread
+static const std::size_t PARALLEL_THRESHOLD = 4096;
+
+// Domain separation of the Merkle tree: leaves and inner nodes hash different inputs
+static const char LEAF_PREFIX = 0x00;
+static const char NODE_PREFIX = 0x01;
+
+// Feeds the record field by field, so no joined string is built
+Hash256 hashTransaction(const Transaction& tx) {
+    const std::string amount = formatMoney(tx.getAmount());
+    const std::string commission = formatMoney(tx.getCommission());
+    const std::string* fields[5] = {&tx.getId(), &tx.getSenderWalletId(), &tx.getRecipientWalletId(),
+                                    &amount, &commission};
+    Sha256 sha;
+    sha.update(&LEAF_PREFIX, 1);
+    for (int i = 0; i < 5; ++i) {
+        if (i > 0) sha.update(";", 1);
+        sha.update(fields[i]->data(), fields[i]->size());
+    }
+    // The commit time is part of the record; transactions without one (0) hash as before
+    if (tx.getTimestamp() != 0) {
+        const std::string timestamp = ";" + std::to_string(tx.getTimestamp());
+        sha.update(timestamp.data(), timestamp.size());
+    }
+    // Halves of a cross-shard transfer also commit to their type; plain transfers hash as before
+    if (tx.getType() != TxType::TRANSFER) {
+        char type[2] = {';', txTypeCode(tx.getType())};
+        sha.update(type, 2);
+    }
+    return sha.finish();
+}
+
+Hash256 hashBlockHeader(const BlockHeader& header) {
+    Sha256 sha;
+    sha.update(&header.index, sizeof(header.index));
+    sha.update(&header.firstSlot, sizeof(header.firstSlot));
+    sha.update(&header.txCount, sizeof(header.txCount));
+    sha.update(header.previousHash.data(), header.previousHash.size());
+    sha.update(header.merkleRoot.data(), header.merkleRoot.size());
+    return sha.finish();
+}
+
+// Hashes pairs level by level until a single node is left
+Hash256 computeMerkleRoot(std::vector<Hash256> nodes, WorkerPool* workers) {
+    if (nodes.empty())
+        return Hash256{};
+
+    while (nodes.size() > 1) {
+        std::size_t parents = (nodes.size() + 1) / 2;
+        std::vector<Hash256> next(parents);
+        auto hashPairs = [&](std::size_t begin, std::size_t end, std::size_t) {
+            for (std::size_t i = begin; i < end; ++i) {
+                if (2 * i + 1 == nodes.size()) {
+                    next[i] = nodes[2 * i];  // Odd last node: promoted as it is
+                    continue;
+                }
+                Sha256 sha;
+                sha.update(&NODE_PREFIX, 1);
+                sha.update(nodes[2 * i].data(), nodes[2 * i].size());
+                sha.update(nodes[2 * i + 1].data(), nodes[2 * i + 1].size());
+                next[i] = sha.finish();
+            }
+        };
+        if (workers && parents >= PARALLEL_THRESHOLD)
+            workers->parallelFor(parents, 1024, hashPairs);
+        else
+            hashPairs(0, parents, 0);
+        nodes.swap(next);
+    }
+    return nodes[0];
+}
@@ -0,0 +1,38 @@
+#ifndef BLOCK_H
+#define BLOCK_H
+
+#include "Sha256.h"
+#include "Transaction.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class WorkerPool;
+
+// Header of a sealed block: a range of transaction slots summarized by a Merkle root
+// and linked to the previous block by its hash
+struct BlockHeader {
+    std::uint64_t index;          // Height of the block (0 = first block)
+    std::uint64_t firstSlot;      // First transaction slot covered by the block
+    std::uint32_t txCount;        // Number of consecutive slots covered
+    Hash256 previousHash;         // Hash of the previous header (all zeros for the first block)
+    Hash256 merkleRoot;           // Merkle root over the hashes of the covered transactions
+    Hash256 hash;                 // Hash of this header
+};
+
+// Merkle leaf of a transaction: SHA-256 of a 0x00 byte, then the transaction's canonical record
+// "id;sender;recipient;amount;commission", ";timestamp" unless the commit time is unknown (0),
+// and ";D" or ";C" for the halves of a cross-shard transfer
+Hash256 hashTransaction(const Transaction& tx);
+
+// SHA-256 over the header fields except the hash itself
+Hash256 hashBlockHeader(const BlockHeader& header);
+
+// Reduces leaf hashes to a Merkle root. An inner node is SHA-256 of a 0x01 byte and its two
+// children, so no inner node can pass for a leaf; an odd last node moves up a level unchanged,
+// so a list and the same list with its last leaf repeated have different roots.
+// Levels with many nodes are hashed in parallel when a worker pool is given.
+// An empty list has an all-zero root.
+Hash256 computeMerkleRoot(std::vector<Hash256> nodes, WorkerPool* workers);
+
+#endif // BLOCK_H
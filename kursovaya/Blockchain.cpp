@@ -1,159 +1,841 @@
 #include "Blockchain.h"
+#include "IdArchive.h"
+#include "LedgerParser.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <cstdio>
-#include <iostream>
-#include <cstring>
 #include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
-Blockchain::Blockchain() {}
+// Prints the malformed records collected while parsing a file
+static void reportParseErrors(const std::string& filename, const LedgerParser& parser) {
+    for (const ParseError& error : parser.getErrors())
+        std::cerr << filename << ":" << error.line << ": " << error.message << "\n";
+}
+
+// Prints how many records of a file were skipped because their transaction ID was already stored
+static void reportDuplicates(const std::string& filename, std::size_t count) {
+    if (count > 0)
+        std::cerr << filename << ": skipped " << count << " transaction(s) with an ID already in the ledger\n";
+}
+
+// Default number of transactions per sealed block
+static const std::size_t DEFAULT_BLOCK_SIZE = 1024;
+
+Blockchain::Blockchain() : idArchive(nullptr), logTicket(0), logFailed(false), sealedSlots(0), blockSize(DEFAULT_BLOCK_SIZE), historySlots(0) {}
 
 Blockchain::~Blockchain() {}
 
-void Blockchain::addClient(Client* client) {
+// Pooled objects are released with their slabs, without a destructor call each
+static_assert(std::is_trivially_destructible<Client>::value, "clients must not own what they point to");
+static_assert(std::is_trivially_destructible<Wallet>::value, "wallets must not own what they point to");
+static_assert(std::is_trivially_destructible<ClientNode>::value, "tree nodes must not own their clients");
+
+Client* Blockchain::addClient(std::string_view clientId, std::string_view name, ClientTier tier) {
+    IdHandle handle = clientIds.intern(clientId);
+    if (clients.find(handle))
+        return nullptr;
+    Client* client = clientPool.create(clientIds.name(handle), clientNames.name(clientNames.intern(name)), tier);
+    client->setHandle(handle);
     clients.insert(client);
-    const auto& wallets = client->getWallets().getAllEntities();
-    for (Entity* e : wallets) {
-        Wallet* w = dynamic_cast<Wallet*>(e);
-        if (w)
-            walletIndex[w->getId()] = w;
-    }
+    return client;
+}
+
+Wallet* Blockchain::createWallet(Client* owner, std::string_view walletId, Money balance) {
+    IdHandle handle = walletIds.intern(walletId);
+    if (findWalletRef(handle))
+        return nullptr;  // Registered to another client (or this one): the index entry stays as it is
+    Wallet* wallet = walletPool.create(walletIds.name(handle), owner->getId(), balance);
+    owner->addWallet(wallet);
+    indexWallet(wallet, owner, handle);
+    return wallet;
 }
 
 Wallet* Blockchain::findWalletById(const std::string& walletId) const {
-    auto it = walletIndex.find(walletId);
-    if (it != walletIndex.end())
-        return it->second;
+    const WalletRef* ref = findWalletRef(walletId);
+    return ref ? ref->wallet : nullptr;
+}
+
+const WalletRef* Blockchain::findWalletRef(const std::string& walletId) const {
+    return findWalletRef(walletIds.find(walletId));
+}
+
+const WalletRef* Blockchain::findWalletRef(IdHandle walletHandle) const {
+    if (walletHandle < walletIndex.size() && walletIndex[walletHandle].wallet)
+        return &walletIndex[walletHandle];
     return nullptr;
 }
 
-bool Blockchain::processTransaction(Transaction* tx) {
-    Wallet* senderWallet = findWalletById(tx->getSenderWalletId());
-    Wallet* recipientWallet = findWalletById(tx->getRecipientWalletId());
+void Blockchain::resolveWallets(Transaction& tx) const {
+    if (tx.getSenderHandle() == NO_HANDLE || tx.getRecipientHandle() == NO_HANDLE)
+        tx.setWalletHandles(walletIds.find(tx.getSenderWalletId()), walletIds.find(tx.getRecipientWalletId()));
+}
 
-    if (!senderWallet || !recipientWallet) {
-        std::cerr << "Sender or recipient wallet not found.\n";
-        return false;
+Client* Blockchain::findClientByWallet(const std::string& walletId) const {
+    const WalletRef* ref = findWalletRef(walletId);
+    return ref ? ref->owner : nullptr;
+}
+
+const char* txStatusMessage(TxStatus status) {
+    switch (status) {
+        case TxStatus::OK:                 return "Transaction successful.";
+        case TxStatus::WALLET_NOT_FOUND:   return "Sender or recipient wallet not found.";
+        case TxStatus::CLIENT_NOT_FOUND:   return "Sender client not found.";
+        case TxStatus::LIMIT_EXCEEDED:     return "Transaction amount exceeds sender's limit.";
+        case TxStatus::INSUFFICIENT_FUNDS: return "Insufficient funds in sender's wallet.";
+        case TxStatus::WITHDRAW_FAILED:    return "Withdrawal failed.";
+        case TxStatus::DUPLICATE_ID:       return "A transaction with this ID already exists.";
+        case TxStatus::LOG_FAILED:         return "The transaction could not be logged.";
+        case TxStatus::INVALID_AMOUNT:     return "Amount must be positive and commission not negative.";
     }
+    return "Unknown transaction status.";
+}
+
+TxStatus Blockchain::localWallets(Transaction& tx, const WalletRef*& sender, const WalletRef*& recipient) const {
+    resolveWallets(tx);
+    sender = tx.getType() != TxType::CREDIT ? findWalletRef(tx.getSenderHandle()) : nullptr;
+    recipient = tx.getType() != TxType::DEBIT ? findWalletRef(tx.getRecipientHandle()) : nullptr;
+    bool found = (sender || tx.getType() == TxType::CREDIT) && (recipient || tx.getType() == TxType::DEBIT);
+    return found ? TxStatus::OK : TxStatus::WALLET_NOT_FOUND;
+}
+
+// A transfer moves a positive amount for a non-negative fee; anything else would mint money
+static bool validAmounts(Money amount, Money commission) {
+    return amount > 0 && commission >= 0;
+}
+
+TxStatus Blockchain::validateTransfer(const Transaction& tx, const WalletRef* sender) const {
+    if (!validAmounts(tx.getAmount(), tx.getCommission()))
+        return TxStatus::INVALID_AMOUNT;
+    if (!sender)
+        return TxStatus::OK;  // A credit half: the sender was checked by its own shard
+    if (!sender->owner)
+        return TxStatus::CLIENT_NOT_FOUND;
+
+    Money amount = tx.getAmount();
+    if (amount > tierPolicy(sender->tier).maxTransaction)
+        return TxStatus::LIMIT_EXCEEDED;
 
-    Client* senderClient = nullptr;
+    if (sender->wallet->getBalance() < amount + tx.getCommission())
+        return TxStatus::INSUFFICIENT_FUNDS;
 
-    std::function<ClientNode*(ClientNode*, Wallet*)> findClientNodeByWallet = [&](ClientNode* node, Wallet* w) -> ClientNode* {
-        if (!node) return nullptr;
-        const auto& ws = node->data->getWallets().getAllEntities();
-        for (Entity* e : ws) {
-            if (e->getId() == w->getId())
-                return node;
+    return TxStatus::OK;
+}
+
+TxStatus Blockchain::moveFunds(const Transaction& tx, const WalletRef* sender, const WalletRef* recipient) {
+    if (sender && !sender->wallet->withdraw(tx.getAmount() + tx.getCommission()))
+        return TxStatus::WITHDRAW_FAILED;
+    if (recipient)
+        recipient->wallet->deposit(tx.getAmount());
+    return TxStatus::OK;
+}
+
+TxStatus Blockchain::transferFunds(const Transaction& tx, const WalletRef* sender, const WalletRef* recipient) {
+    TxStatus status = validateTransfer(tx, sender);
+    if (status != TxStatus::OK)
+        return status;
+    return moveFunds(tx, sender, recipient);
+}
+
+void Blockchain::indexHistory() {
+    std::size_t end = transactions.getSlotCount();
+    for (; historySlots < end; ++historySlots) {
+        const Transaction* tx = transactions.getAt(historySlots);
+        if (!tx) {
+            rangeIndex.append(0, RangeIndex::EMPTY_AMOUNT);
+            continue;
         }
-        ClientNode* found = findClientNodeByWallet(node->left, w);
-        if (found)
-            return found;
-        return findClientNodeByWallet(node->right, w);
-    };
+        rangeIndex.append(tx->getTimestamp(), tx->getAmount());
+        // Wallets that are not indexed (yet) still get a handle, so their history is kept
+        IdHandle sender = tx->getSenderHandle();
+        if (sender == NO_HANDLE) sender = walletIds.intern(tx->getSenderWalletId());
+        IdHandle recipient = tx->getRecipientHandle();
+        if (recipient == NO_HANDLE) recipient = walletIds.intern(tx->getRecipientWalletId());
 
-    ClientNode* senderNode = findClientNodeByWallet(clients.getRoot(), senderWallet);
-    if (!senderNode) {
-        std::cerr << "Sender client not found.\n";
-        return false;
+        if (std::max(sender, recipient) >= walletHistory.size())
+            walletHistory.resize(std::max(sender, recipient) + 1);
+        walletHistory[sender].push_back(historySlots);
+        if (recipient != sender)
+            walletHistory[recipient].push_back(historySlots);
     }
-    senderClient = senderNode->data;
+}
 
-    double amount = tx->getAmount();
-    double commission = tx->getCommission();
+std::vector<const Transaction*> Blockchain::getWalletHistory(const std::string& walletId, std::size_t offset,
+                                                             std::size_t limit) const {
+    std::vector<const Transaction*> page;
+    IdHandle handle = walletIds.find(walletId);
+    if (handle >= walletHistory.size())
+        return page;
+    const std::vector<std::uint64_t>& slots = walletHistory[handle];
+    if (offset >= slots.size())
+        return page;
 
-    if (amount > senderClient->getMaxTransactionLimit()) {
-        std::cerr << "Transaction amount exceeds sender's limit.\n";
-        return false;
+    std::size_t count = std::min(limit, slots.size() - offset);
+    page.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const Transaction* tx = transactions.getAt(static_cast<std::size_t>(slots[slots.size() - 1 - offset - i]));
+        if (tx) page.push_back(tx);
     }
+    return page;
+}
 
-    if (senderWallet->getBalance() < amount + commission) {
-        std::cerr << "Insufficient funds in sender's wallet.\n";
-        return false;
+std::size_t Blockchain::getWalletHistorySize(const std::string& walletId) const {
+    IdHandle handle = walletIds.find(walletId);
+    return handle < walletHistory.size() ? walletHistory[handle].size() : 0;
+}
+
+Timestamp Blockchain::commitTime() const {
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    // A clock stepping back must not break the time order of the range index
+    return std::max(static_cast<Timestamp>(now), rangeIndex.latest());
+}
+
+std::vector<const Transaction*> Blockchain::transactionsAt(const std::vector<std::size_t>& slots) const {
+    std::vector<const Transaction*> result;
+    result.reserve(slots.size());
+    for (std::size_t slot : slots) {
+        if (const Transaction* tx = transactions.getAt(slot))
+            result.push_back(tx);
     }
+    return result;
+}
+
+std::vector<const Transaction*> Blockchain::getTransactionsBetween(Timestamp from, Timestamp to) const {
+    std::size_t first, last;
+    rangeIndex.slotRange(from, to, first, last);
+    std::vector<std::size_t> slots(last - first);
+    for (std::size_t i = 0; i < slots.size(); ++i)
+        slots[i] = first + i;
+    return transactionsAt(slots);
+}
+
+std::vector<const Transaction*> Blockchain::getTransfersAbove(Money amount, Timestamp from, Timestamp to) const {
+    std::size_t first, last;
+    rangeIndex.slotRange(from, to, first, last);
+    return transactionsAt(rangeIndex.slotsAbove(amount, first, last));
+}
+
+void Blockchain::repositionOwners(const WalletRef* sender, const WalletRef* recipient) {
+    Client* senderOwner = sender ? sender->owner : nullptr;
+    if (senderOwner)
+        clients.updateBalance(senderOwner);
+    if (recipient && recipient->owner && recipient->owner != senderOwner)
+        clients.updateBalance(recipient->owner);
+}
 
-    if (!senderWallet->withdraw(amount + commission)) {
-        std::cerr << "Withdrawal failed.\n";
+TxStatus Blockchain::applyTransfer(Transaction* tx, const WalletRef* sender, const WalletRef* recipient) {
+    TxStatus status = transferFunds(*tx, sender, recipient);
+    if (status != TxStatus::OK)
+        return status;
+
+    // Keep the balance-ordered client index in sync with the new totals
+    repositionOwners(sender, recipient);
+    return TxStatus::OK;
+}
+
+bool Blockchain::processTransaction(Transaction* tx) {
+    if (processTransaction(std::move(*tx)) != TxStatus::OK)
         return false;
+    delete tx;  // Its contents now live in the store
+    return true;
+}
+
+// Nanoseconds between two time points
+static std::uint64_t elapsedNs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+TxStatus Blockchain::processTransaction(Transaction&& tx) {
+    auto start = std::chrono::steady_clock::now();
+    const WalletRef* sender = nullptr;
+    const WalletRef* recipient = nullptr;
+    TxStatus status = logFailed ? TxStatus::LOG_FAILED : TxStatus::DUPLICATE_ID;
+    if (!logFailed && !isCommitted(tx.getId())) {
+        status = localWallets(tx, sender, recipient);
+        if (status == TxStatus::OK)
+            status = validateTransfer(tx, sender);
     }
-    recipientWallet->deposit(amount);
+    auto validated = std::chrono::steady_clock::now();
+    metrics.recordValidate(elapsedNs(start, validated));
 
-    transactions.addTransaction(tx);
+    if (status == TxStatus::OK) {
+        status = moveFunds(tx, sender, recipient);
+        if (status == TxStatus::OK) {
+            repositionOwners(sender, recipient);
+            tx.setTimestamp(commitTime());
+            Transaction* stored = transactions.addTransaction(std::move(tx));
+            logCommitted(&stored, 1);
+            indexHistory();
+            sealFullBlocks();
+        }
+        metrics.recordApply(elapsedNs(validated, std::chrono::steady_clock::now()));
+    }
+
+    metrics.recordOutcome(status);
+    return status;
+}
 
+bool Blockchain::processTransactionFile(const std::string& filename, ReplayStats& stats) {
+    stats = ReplayStats{0, 0, 0, 0};
+    LedgerParser parser;
+    if (!parser.open(filename)) return false;
+
+    std::string_view line;
+    while (parser.nextLine(line)) {
+        TransactionRecord record;
+        if (!LedgerParser::parseTransactionRecord(line, record)) {
+            parser.reportError("malformed transaction record");
+            stats.malformed++;
+            continue;
+        }
+        TxStatus status = processTransaction(Transaction(std::string(record.id), std::string(record.senderWalletId),
+                                                         std::string(record.recipientWalletId), record.amount,
+                                                         record.type, record.commission));
+        if (status == TxStatus::OK)
+            stats.accepted++;
+        else if (status == TxStatus::DUPLICATE_ID)
+            stats.duplicates++;
+        else
+            stats.rejected++;
+    }
+
+    reportParseErrors(filename, parser);
     return true;
 }
 
-void Blockchain::displayClients() const {
-    clients.displayInOrder();
+// Commit times must not go back in the store, so the range index holds each record's own time
+bool Blockchain::inTimeOrder(Timestamp time, Timestamp& latest) {
+    if (time < latest)
+        return false;
+    latest = time;
+    return true;
 }
 
-void Blockchain::displayTransactions() const {
-    transactions.displayTransactions();
+bool Blockchain::isCommitted(std::string_view id) const {
+    // Both check a Bloom filter first, so an ID never seen costs a cache line per filter
+    return transactions.contains(id) || (idArchive && idArchive->contains(id));
 }
 
-bool Blockchain::saveClientsToFile(const std::string& filename) const {
+void Blockchain::markDuplicates(Transaction* const* txs, std::size_t count, std::vector<TxStatus>& statuses) const {
+    std::unordered_set<std::string_view> batchIds;
+    batchIds.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::string& id = txs[i]->getId();
+        if (isCommitted(id) || !batchIds.insert(id).second)
+            statuses[i] = TxStatus::DUPLICATE_ID;
+    }
+}
+
+std::vector<TxStatus> Blockchain::refuseUnlogged(std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i)
+        metrics.recordOutcome(TxStatus::LOG_FAILED);
+    return std::vector<TxStatus>(count, TxStatus::LOG_FAILED);
+}
+
+std::vector<TxStatus> Blockchain::processTransactions(Transaction* const* txs, std::size_t count) {
+    if (logFailed)
+        return refuseUnlogged(count);
+    std::vector<TxStatus> statuses(count, TxStatus::OK);
+    markDuplicates(txs, count, statuses);
+    std::vector<Transaction*> accepted;
+    accepted.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (statuses[i] != TxStatus::OK)
+            continue;
+        Transaction* tx = txs[i];
+        const WalletRef* sender;
+        const WalletRef* recipient;
+        statuses[i] = localWallets(*tx, sender, recipient);
+        if (statuses[i] != TxStatus::OK)
+            continue;
+
+        statuses[i] = applyTransfer(tx, sender, recipient);
+        if (statuses[i] == TxStatus::OK)
+            accepted.push_back(tx);
+    }
+    for (TxStatus status : statuses)
+        metrics.recordOutcome(status);
+
+    // The batch commits as one step, at one time
+    Timestamp now = commitTime();
+    for (Transaction* tx : accepted)
+        tx->setTimestamp(now);
+
+    // Log before the store takes the accepted transactions over
+    logCommitted(accepted.data(), accepted.size());
+    transactions.addTransactions(accepted.data(), accepted.size());
+    indexHistory();
+    sealFullBlocks();
+
+    return statuses;
+}
+
+std::vector<TxStatus> Blockchain::processTransactionsParallel(Transaction* const* txs, std::size_t count,
+                                                              std::size_t threadCount) {
+    if (logFailed)
+        return refuseUnlogged(count);
+    const std::size_t participants = participantsFor(threadCount);
+    WorkerPool& pool = getWorkers(participants);
+
+    // Outcomes are recorded where they are decided: duplicates here, the rest on the workers
+    // (each into its own metrics shard)
+    std::vector<TxStatus> statuses(count, TxStatus::OK);
+    markDuplicates(txs, count, statuses);
+    for (TxStatus status : statuses) {
+        if (status != TxStatus::OK)
+            metrics.recordOutcome(status);
+    }
+    std::vector<const WalletRef*> senders(count, nullptr);
+    std::vector<const WalletRef*> recipients(count, nullptr);
+    pool.parallelFor(count, 1024, [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (statuses[i] != TxStatus::OK) continue;
+            statuses[i] = localWallets(*txs[i], senders[i], recipients[i]);
+            if (statuses[i] != TxStatus::OK)
+                metrics.recordOutcome(statuses[i]);
+        }
+    }, participants);
+
+    // Waves: a transfer goes one wave after the last one touching either of its wallets, so the
+    // transfers of a wave share no wallet and every wallet sees its transfers in input order.
+    // Running the waves one after another therefore gives exactly the serial result, which is
+    // what the log (written in input order) replays.
+    std::vector<std::vector<std::size_t>> waves;
+    std::unordered_map<const Wallet*, std::size_t> nextWave;  // Wallet -> first wave it is free in
+    nextWave.reserve(count * 2);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (statuses[i] != TxStatus::OK) continue;
+        const Wallet* a = senders[i] ? senders[i]->wallet : nullptr;
+        const Wallet* b = recipients[i] ? recipients[i]->wallet : nullptr;
+        std::size_t wave = 0;
+        if (a) wave = std::max(wave, nextWave[a]);
+        if (b) wave = std::max(wave, nextWave[b]);
+        if (a) nextWave[a] = wave + 1;
+        if (b) nextWave[b] = wave + 1;
+        if (wave == waves.size()) waves.emplace_back();
+        waves[wave].push_back(i);
+    }
+
+    // Clients whose totals changed, collected per worker and repositioned after the parallel phase
+    std::vector<std::vector<Client*>> touched(pool.getThreadCount());
+    auto runWave = [&](const std::vector<std::size_t>& wave, std::size_t begin, std::size_t end, std::size_t worker) {
+        for (std::size_t k = begin; k < end; ++k) {
+            std::size_t i = wave[k];
+            const WalletRef* sender = senders[i];
+            const WalletRef* recipient = recipients[i];
+            statuses[i] = transferFunds(*txs[i], sender, recipient);
+            metrics.recordOutcome(statuses[i]);
+            if (statuses[i] != TxStatus::OK) continue;
+            Client* senderOwner = sender ? sender->owner : nullptr;
+            if (senderOwner)
+                touched[worker].push_back(senderOwner);
+            if (recipient && recipient->owner && recipient->owner != senderOwner)
+                touched[worker].push_back(recipient->owner);
+        }
+    };
+    for (const std::vector<std::size_t>& wave : waves) {
+        // Small waves (hot wallets) are not worth a hand-off to the workers
+        if (wave.size() < 512)
+            runWave(wave, 0, wave.size(), 0);
+        else
+            pool.parallelFor(wave.size(), 256, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+                runWave(wave, begin, end, worker);
+            }, participants);
+    }
+
+    for (const auto& owners : touched) {
+        for (Client* owner : owners)
+            clients.updateBalance(owner);
+    }
+
+    std::vector<Transaction*> accepted;
+    accepted.reserve(count);
+    Timestamp now = commitTime();
+    for (std::size_t i = 0; i < count; ++i) {
+        if (statuses[i] == TxStatus::OK) {
+            txs[i]->setTimestamp(now);
+            accepted.push_back(txs[i]);
+        }
+    }
+    logCommitted(accepted.data(), accepted.size());
+    transactions.addTransactions(accepted.data(), accepted.size());
+    indexHistory();
+    sealFullBlocks();
+
+    return statuses;
+}
+
+std::size_t Blockchain::participantsFor(std::size_t threadCount) {
+    return threadCount != 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+}
+
+WorkerPool& Blockchain::getWorkers(std::size_t participants) {
+    if (!workers || workers->getThreadCount() < participants)
+        workers.reset(new WorkerPool(std::max(participants, participantsFor(0))));
+    return *workers;
+}
+
+void Blockchain::sealSlots(std::size_t firstSlot, std::size_t count, std::size_t maxPerBlock) {
+    if (count == 0)
+        return;
+
+    // Leaf hashes for the whole range in one parallel pass; removed transactions hash to zeros
+    std::vector<Hash256> leaves(count);
+    auto hashLeaves = [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const Transaction* tx = transactions.getAt(firstSlot + i);
+            leaves[i] = tx ? hashTransaction(*tx) : Hash256{};
+        }
+    };
+    WorkerPool* pool = count >= 4096 ? &getWorkers(participantsFor(0)) : nullptr;
+    if (pool)
+        pool->parallelFor(count, 512, hashLeaves);
+    else
+        hashLeaves(0, count, 0);
+
+    for (std::size_t offset = 0; offset < count; offset += maxPerBlock) {
+        std::size_t size = std::min(maxPerBlock, count - offset);
+        BlockHeader header;
+        header.index = blocks.size();
+        header.firstSlot = firstSlot + offset;
+        header.txCount = static_cast<std::uint32_t>(size);
+        header.previousHash = blocks.empty() ? Hash256{} : blocks.back().hash;
+        header.merkleRoot = computeMerkleRoot(std::vector<Hash256>(leaves.begin() + offset, leaves.begin() + offset + size),
+                                              pool);
+        header.hash = hashBlockHeader(header);
+        blocks.push_back(header);
+    }
+    sealedSlots = firstSlot + count;
+}
+
+void Blockchain::sealFullBlocks() {
+    std::size_t pending = transactions.getSlotCount() - sealedSlots;
+    std::size_t full = pending / blockSize * blockSize;
+    sealSlots(sealedSlots, full, blockSize);
+}
+
+void Blockchain::setBlockSize(std::size_t size) {
+    blockSize = std::max<std::size_t>(size, 1);
+}
+
+std::size_t Blockchain::getBlockSize() const {
+    return blockSize;
+}
+
+bool Blockchain::sealBlock() {
+    std::size_t pending = transactions.getSlotCount() - sealedSlots;
+    if (pending == 0)
+        return false;
+    sealSlots(sealedSlots, pending, pending);
+    return true;
+}
+
+const std::vector<BlockHeader>& Blockchain::getBlocks() const {
+    return blocks;
+}
+
+bool Blockchain::saveBlocksToFile(const std::string& filename) const {
     FILE* file = fopen(filename.c_str(), "w");
     if (!file) return false;
 
-    std::function<void(ClientNode*)> saveNode = [&](ClientNode* node) {
-        if (!node) return;
+    for (const BlockHeader& block : blocks) {
+        fprintf(file, "%llu;%llu;%u;%s;%s;%s\n", static_cast<unsigned long long>(block.index),
+                static_cast<unsigned long long>(block.firstSlot), static_cast<unsigned>(block.txCount),
+                hashToHex(block.previousHash).c_str(), hashToHex(block.merkleRoot).c_str(),
+                hashToHex(block.hash).c_str());
+    }
 
-        saveNode(node->left);
+    fclose(file);
+    return true;
+}
 
-        std::string clientType = "Standard";
-        if (dynamic_cast<GoldClient*>(node->data)) clientType = "Gold";
-        else if (dynamic_cast<PlatinumClient*>(node->data)) clientType = "Platinum";
+bool Blockchain::loadBlocksFromFile(const std::string& filename) {
+    LedgerParser parser;
+    if (!parser.open(filename)) return false;
 
-        fprintf(file, "%s;%s;%s\n", node->data->getId().c_str(), node->data->getName().c_str(), clientType.c_str());
+    std::string_view line;
+    bool rootChecked = false;
+    while (parser.nextLine(line)) {
+        BlockRecord record;
+        BlockHeader header;
+        if (!LedgerParser::parseBlockRecord(line, record) || !hashFromHex(record.previousHash, header.previousHash) ||
+            !hashFromHex(record.merkleRoot, header.merkleRoot) || !hashFromHex(record.hash, header.hash)) {
+            parser.reportError("malformed block record");
+            continue;
+        }
+        header.index = record.index;
+        header.firstSlot = record.firstSlot;
+        header.txCount = record.txCount;
 
-        const auto& wallets = node->data->getWallets().getAllEntities();
-        for (Entity* e : wallets) {
-            Wallet* w = dynamic_cast<Wallet*>(e);
-            if (w) {
-                fprintf(file, "W;%s;%.2f\n", w->getId().c_str(), w->getBalance());
+        // Blocks must continue the chain and cover transactions that are loaded
+        std::uint64_t end = header.firstSlot + header.txCount;
+        if (header.index != blocks.size() || header.firstSlot != sealedSlots || end > transactions.getSlotCount()) {
+            parser.reportError("block does not continue the loaded chain");
+            continue;
+        }
+        // The first block's root tells whether the file matches these transactions and this
+        // Merkle tree; files written before leaves and nodes were domain-separated do not
+        if (!rootChecked) {
+            rootChecked = true;
+            std::vector<Hash256> leaves;
+            for (std::uint64_t slot = header.firstSlot; slot < end; ++slot) {
+                const Transaction* tx = transactions.getAt(static_cast<std::size_t>(slot));
+                leaves.push_back(tx ? hashTransaction(*tx) : Hash256{});
+            }
+            if (computeMerkleRoot(std::move(leaves), nullptr) != header.merkleRoot) {
+                std::cerr << filename << ": blocks do not match the loaded transactions (or use an older Merkle tree), "
+                          << "they will be sealed again\n";
+                break;
             }
         }
+        blocks.push_back(header);
+        sealedSlots = static_cast<std::size_t>(end);
+    }
+
+    reportParseErrors(filename, parser);
+    return true;
+}
 
-        saveNode(node->right);
+VerificationReport Blockchain::verifyLedger(std::size_t threadCount) {
+    const std::size_t shards = participantsFor(threadCount);
+    WorkerPool& pool = getWorkers(shards);
+    const std::size_t slots = transactions.getSlotCount();
+
+    VerificationReport report{true, transactions.getSize(), blocks.size(), std::string(), std::string()};
+
+    // Earliest problem found so far, by slot (and by block index for blocks)
+    std::mutex divergenceMutex;
+    std::size_t divergenceSlot = SIZE_MAX, divergenceBlock = SIZE_MAX;
+    auto diverge = [&](std::size_t slot, const std::string& message) {
+        std::lock_guard<std::mutex> guard(divergenceMutex);
+        if (slot < divergenceSlot) {
+            divergenceSlot = slot;
+            report.divergence = message;
+        }
+    };
+    auto describe = [](const Transaction& tx, std::size_t slot) {
+        return "transaction " + tx.getId() + " (#" + std::to_string(slot) + ")";
     };
+    // Wallet handle of a stored transaction side; IDs unknown at intake are looked up again
+    auto handleOf = [this](IdHandle handle, const std::string& walletId) {
+        return handle != NO_HANDLE ? handle : walletIds.find(walletId);
+    };
+
+    // Pass 1, split by slot range: per-transaction checks, and balance events bucketed by wallet shard.
+    // Worker w handles the w-th contiguous range, so reading buckets in worker order keeps log order.
+    struct BalanceEvent {
+        std::size_t slot;
+        IdHandle wallet;
+        Money delta;
+    };
+    std::vector<std::vector<std::vector<BalanceEvent>>> buckets(shards, std::vector<std::vector<BalanceEvent>>(shards));
+    pool.run([&](std::size_t worker) {
+        std::size_t begin = slots * worker / shards;
+        std::size_t end = slots * (worker + 1) / shards;
+        for (std::size_t i = begin; i < end; ++i) {
+            const Transaction* tx = transactions.getAt(i);
+            if (!tx) continue;
+            IdHandle senderHandle = handleOf(tx->getSenderHandle(), tx->getSenderWalletId());
+            IdHandle recipientHandle = handleOf(tx->getRecipientHandle(), tx->getRecipientWalletId());
+            // A debit half only checks and moves its sender, a credit half only its recipient
+            bool hasSender = tx->getType() != TxType::CREDIT;
+            bool hasRecipient = tx->getType() != TxType::DEBIT;
+            const WalletRef* sender = hasSender ? findWalletRef(senderHandle) : nullptr;
+            const WalletRef* recipient = hasRecipient ? findWalletRef(recipientHandle) : nullptr;
+            if ((hasSender && !sender) || (hasRecipient && !recipient)) {
+                diverge(i, describe(*tx, i) + ": unknown wallet " +
+                        (hasSender && !sender ? tx->getSenderWalletId() : tx->getRecipientWalletId()));
+                continue;
+            }
+            if (sender && !sender->owner) {
+                diverge(i, describe(*tx, i) + ": sender wallet " + tx->getSenderWalletId() + " has no owner");
+                continue;
+            }
+            Money amount = tx->getAmount();
+            Money commission = tx->getCommission();
+            if (!validAmounts(amount, commission)) {
+                diverge(i, describe(*tx, i) + ": invalid amount or commission");
+                continue;
+            }
+            if (sender && amount > tierPolicy(sender->tier).maxTransaction) {
+                diverge(i, describe(*tx, i) + ": amount exceeds the limit of client " + sender->owner->getId());
+                continue;
+            }
+            if (sender)
+                buckets[worker][senderHandle % shards].push_back({i, senderHandle, -(amount + commission)});
+            if (recipient)
+                buckets[worker][recipientHandle % shards].push_back({i, recipientHandle, amount});
+        }
+    }, shards);
+
+    // Pass 2, split by wallet shard: derive opening balances, then replay each wallet in log order.
+    // Shards own disjoint handles, so they share one state array without locking.
+    struct WalletState {
+        Money net;              // Net effect of the log on the wallet
+        Money balance;          // Replayed balance
+        std::size_t firstSlot;  // First transaction touching the wallet
+        int phase;              // 0 = untouched, 1 = net summed, 2 = replaying
+    };
+    std::vector<WalletState> states(walletIndex.size(), WalletState{0, 0, 0, 0});
+    pool.run([&](std::size_t shard) {
+        for (std::size_t w = 0; w < shards; ++w) {
+            for (const BalanceEvent& e : buckets[w][shard]) {
+                WalletState& state = states[e.wallet];
+                if (state.phase == 0) {
+                    state.phase = 1;
+                    state.firstSlot = e.slot;
+                }
+                state.net += e.delta;
+            }
+        }
+        for (std::size_t w = 0; w < shards; ++w) {
+            for (const BalanceEvent& e : buckets[w][shard]) {
+                WalletState& state = states[e.wallet];
+                const Wallet* wallet = walletIndex[e.wallet].wallet;
+                if (state.phase == 1) {
+                    state.phase = 2;
+                    state.balance = wallet->getBalance() - state.net;
+                    if (state.balance < 0) {
+                        diverge(state.firstSlot, "wallet " + wallet->getId() + ": balance " +
+                                formatMoney(wallet->getBalance()) + " is lower than the log allows");
+                    }
+                }
+                if (e.delta < 0 && state.balance < -e.delta) {
+                    diverge(e.slot, describe(*transactions.getAt(e.slot), e.slot) + ": wallet " + wallet->getId() +
+                            " has " + formatMoney(state.balance) + ", needs " + formatMoney(-e.delta));
+                    return;  // Later events of this shard cannot be earlier than this one
+                }
+                state.balance += e.delta;
+            }
+        }
+    }, shards);
+
+    // Blocks, split by block range: chain links, covered ranges, Merkle roots and header hashes
+    pool.parallelFor(blocks.size(), 4, [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t b = begin; b < end; ++b) {
+            const BlockHeader& block = blocks[b];
+            std::uint64_t expectedFirst = b == 0 ? 0 : blocks[b - 1].firstSlot + blocks[b - 1].txCount;
+            Hash256 expectedPrevious = b == 0 ? Hash256{} : blocks[b - 1].hash;
+
+            const char* problem = nullptr;
+            if (block.index != b || block.firstSlot != expectedFirst || block.firstSlot + block.txCount > slots) {
+                problem = "covers the wrong transaction range";
+            } else if (block.previousHash != expectedPrevious) {
+                problem = "does not link to the previous block";
+            } else {
+                std::vector<Hash256> leaves(block.txCount);
+                for (std::uint32_t i = 0; i < block.txCount; ++i) {
+                    const Transaction* tx = transactions.getAt(block.firstSlot + i);
+                    leaves[i] = tx ? hashTransaction(*tx) : Hash256{};
+                }
+                if (computeMerkleRoot(std::move(leaves), nullptr) != block.merkleRoot)
+                    problem = "Merkle root does not match its transactions";
+                else if (hashBlockHeader(block) != block.hash)
+                    problem = "header hash does not match";
+            }
+
+            if (problem) {
+                std::lock_guard<std::mutex> guard(divergenceMutex);
+                if (b < divergenceBlock) {
+                    divergenceBlock = b;
+                    report.blockDivergence = "block " + std::to_string(b) + ": " + problem;
+                }
+            }
+        }
+    }, shards);
+
+    report.ok = report.divergence.empty() && report.blockDivergence.empty();
+    return report;
+}
+
+MetricsSnapshot Blockchain::getMetrics() const {
+    MetricsSnapshot snapshot;
+    metrics.collect(snapshot);
+    snapshot.clients = clients.size();
+    snapshot.wallets = walletPool.size();
+    snapshot.transactions = transactions.getSize();
+    snapshot.transactionSlots = transactions.getSlotCount();
+    snapshot.blocks = blocks.size();
+    snapshot.pendingTransactions = transactions.getSlotCount() - sealedSlots;
+    return snapshot;
+}
+
+void Blockchain::resetMetrics() {
+    metrics.reset();
+}
+
+void Blockchain::dumpMetrics(std::ostream& out) const {
+    printMetrics(out, getMetrics());
+}
 
-    saveNode(clients.getRoot());
+void Blockchain::displayClients() const {
+    clients.displayInOrder();
+}
+
+void Blockchain::displayTransactions() const {
+    transactions.displayTransactions();
+}
+
+bool Blockchain::saveClientsToFile(const std::string& filename) const {
+    FILE* file = fopen(filename.c_str(), "w");
+    if (!file) return false;
+
+    clients.forEachInOrder([&](Client* client) {
+        fprintf(file, "%s;%s;%s\n", client->getId().c_str(), client->getName().c_str(), tierName(client->getTier()));
+
+        for (const Wallet* w = client->getFirstWallet(); w; w = w->getNextOfOwner()) {
+            fprintf(file, "W;%s;%s\n", w->getId().c_str(), formatMoney(w->getBalance()).c_str());
+        }
+    });
 
     fclose(file);
     return true;
 }
 
 bool Blockchain::loadClientsFromFile(const std::string& filename) {
-    FILE* file = fopen(filename.c_str(), "r");
-    if (!file) return false;
+    LedgerParser parser;
+    if (!parser.open(filename)) return false;
 
-    char line[256];
+    std::string_view line;
     Client* currentClient = nullptr;
 
-    while (fgets(line, sizeof(line), file)) {
-        if (line[0] != 'W') {
-            char id[50], name[50], type[20];
-            sscanf(line, "%[^;];%[^;];%s", id, name, type);
-
-            if (strcmp(type, "Gold") == 0)
-                currentClient = new GoldClient(id, name);
-            else if (strcmp(type, "Platinum") == 0)
-                currentClient = new PlatinumClient(id, name);
-            else
-                currentClient = new StandardClient(id, name);
+    while (parser.nextLine(line)) {
+        if (!LedgerParser::isWalletRecord(line)) {
+            ClientRecord record;
+            if (!LedgerParser::parseClientRecord(line, record)) {
+                parser.reportError("malformed client record");
+                currentClient = nullptr;
+                continue;
+            }
 
-            addClient(currentClient);
+            // Unknown tier names load as Standard
+            ClientTier tier = ClientTier::STANDARD;
+            tierFromName(record.type, tier);
+            // A client already present keeps its wallets; skip the duplicate record (nullptr)
+            currentClient = addClient(record.id, record.name, tier);
         } else {
-            char wid[50];
-            double balance;
-            sscanf(line, "W;%[^;];%lf", wid, &balance);
-            if (currentClient) {
-                Wallet* wallet = new Wallet(wid, currentClient->getId(), balance);
-                currentClient->addWallet(wallet);
-                // Mettre à jour l'index wallet
-                walletIndex[wallet->getId()] = wallet;
+            WalletRecord record;
+            if (!LedgerParser::parseWalletRecord(line, record)) {
+                parser.reportError("malformed wallet record");
+                continue;
             }
+            if (currentClient && !createWallet(currentClient, record.id, record.balance))
+                parser.reportError("wallet ID already registered, record skipped");
         }
     }
 
-    fclose(file);
+    reportParseErrors(filename, parser);
     return true;
 }
 
@@ -161,41 +843,437 @@ bool Blockchain::saveTransactionsToFile(const std::string& filename) const {
     FILE* file = fopen(filename.c_str(), "w");
     if (!file) return false;
 
-    TransactionNode* current = transactions.getHead();
-    while (current) {
-        Transaction* tx = current->data;
-        fprintf(file, "%s;%s;%s;%.2f;%.2f\n", tx->getId().c_str(), tx->getSenderWalletId().c_str(),
-                tx->getRecipientWalletId().c_str(), tx->getAmount(), tx->getCommission());
-        current = current->next;
-    }
+    transactions.forEach([&](const Transaction& tx) {
+        fprintf(file, "%s\n", formatTransactionRecord(tx).c_str());
+    });
 
     fclose(file);
     return true;
 }
 
 bool Blockchain::loadTransactionsFromFile(const std::string& filename) {
-    FILE* file = fopen(filename.c_str(), "r");
-    if (!file) return false;
+    LedgerParser parser;
+    if (!parser.open(filename)) return false;
 
-    char line[256];
+    std::string_view line;
+    std::size_t duplicates = 0;
+    Timestamp latest = rangeIndex.latest();
 
-    while (fgets(line, sizeof(line), file)) {
-        char id[50], sender[50], recipient[50];
-        double amount, commission;
-        sscanf(line, "%[^;];%[^;];%[^;];%lf;%lf", id, sender, recipient, &amount, &commission);
-        Transaction* tx = new Transaction(id, sender, recipient, amount, TxType::TRANSFER, commission);
-        transactions.addTransaction(tx);
+    while (parser.nextLine(line)) {
+        TransactionRecord record;
+        if (!LedgerParser::parseTransactionRecord(line, record)) {
+            parser.reportError("malformed transaction record");
+            continue;
+        }
+        // Loading the same file twice must not store its transactions twice
+        if (isCommitted(record.id)) {
+            duplicates++;
+            continue;
+        }
+        if (!inTimeOrder(record.timestamp, latest)) {
+            parser.reportError("transaction " + std::string(record.id) + " is older than the one before it");
+            continue;
+        }
+        if (!validAmounts(record.amount, record.commission)) {
+            parser.reportError("transaction " + std::string(record.id) + " has an invalid amount or commission");
+            continue;
+        }
+        Transaction tx(std::string(record.id), std::string(record.senderWalletId),
+                       std::string(record.recipientWalletId), record.amount, record.type, record.commission,
+                       record.timestamp);
+        resolveWallets(tx);
+        transactions.addTransaction(std::move(tx));
     }
+    indexHistory();
 
-    fclose(file);
+    reportParseErrors(filename, parser);
+    reportDuplicates(filename, duplicates);
     return true;
 }
 
+SnapshotSection Blockchain::encodeClients(StringTable& strings, bool shareIds) const {
+    // IDs are unique in the ledger: they need the lookup only if later sections refer to them
+    auto id = [&](const std::string& value) { return shareIds ? strings.intern(value) : strings.add(value); };
+    SnapshotSection clientSection{SECTION_CLIENTS, ByteBuffer()};
+    ByteBuffer& cs = clientSection.payload;
+    cs.putU32(static_cast<std::uint32_t>(clients.size()));
+    clients.forEachInOrder([&](Client* client) {
+        cs.putU32(id(client->getId()));
+        cs.putU32(strings.intern(client->getName()));
+        cs.putU8(static_cast<std::uint8_t>(client->getTier()));
+
+        cs.putU32(static_cast<std::uint32_t>(client->getWalletCount()));
+        for (const Wallet* w = client->getFirstWallet(); w; w = w->getNextOfOwner()) {
+            cs.putU32(id(w->getId()));
+            cs.putI64(w->getBalance());
+        }
+    });
+    return clientSection;
+}
+
+bool Blockchain::saveSnapshot(const std::string& filename) const {
+    // Client and wallet IDs are deduplicated; transaction IDs are unique and appended directly
+    StringTable strings;
+    strings.reserve(clients.size() * 2 + walletIndex.size());
+    SnapshotSection clientSection = encodeClients(strings, true);
+
+    SnapshotSection txSection{SECTION_TRANSACTIONS, ByteBuffer()};
+    ByteBuffer& ts = txSection.payload;
+    ts.putU64(static_cast<std::uint64_t>(transactions.getSize()));
+    transactions.forEach([&](const Transaction& tx) {
+        ts.putU32(strings.add(tx.getId()));
+        ts.putU32(strings.intern(tx.getSenderWalletId()));
+        ts.putU32(strings.intern(tx.getRecipientWalletId()));
+        ts.putI64(tx.getAmount());
+        ts.putI64(tx.getCommission());
+        ts.putI64(tx.getTimestamp());
+        ts.putU8(static_cast<std::uint8_t>(txTypeCode(tx.getType())));
+    });
+
+    SnapshotSection blockSection{SECTION_BLOCKS, ByteBuffer()};
+    ByteBuffer& bs = blockSection.payload;
+    bs.putU64(blocks.size());
+    for (const BlockHeader& block : blocks) {
+        bs.putU64(block.index);
+        bs.putU64(block.firstSlot);
+        bs.putU32(block.txCount);
+        bs.putBytes(reinterpret_cast<const char*>(block.previousHash.data()), block.previousHash.size());
+        bs.putBytes(reinterpret_cast<const char*>(block.merkleRoot.data()), block.merkleRoot.size());
+        bs.putBytes(reinterpret_cast<const char*>(block.hash.data()), block.hash.size());
+    }
+
+    // The string table must precede the sections referencing it
+    std::vector<SnapshotSection> sections;
+    sections.push_back({SECTION_STRINGS, strings.encode()});
+    sections.push_back(std::move(clientSection));
+    sections.push_back(std::move(txSection));
+    sections.push_back(std::move(blockSection));
+    return replaceSnapshotFile(filename, sections);
+}
+
+void Blockchain::captureCheckpoint(std::uint64_t firstTailSegment, std::vector<SnapshotSection>& sections) const {
+    StringTable strings;
+    strings.reserve(clients.size());
+    SnapshotSection clientSection = encodeClients(strings, false);
+
+    SnapshotSection checkpointSection{SECTION_CHECKPOINT, ByteBuffer()};
+    checkpointSection.payload.putU64(firstTailSegment);
+    checkpointSection.payload.putI64(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+
+    // The CKPT section comes first, so recovery can read it without decoding the rest
+    sections.clear();
+    sections.push_back(std::move(checkpointSection));
+    sections.push_back({SECTION_STRINGS, strings.encode()});
+    sections.push_back(std::move(clientSection));
+}
+
+void Blockchain::setIdArchive(const IdArchive* archive) {
+    idArchive = archive;
+}
+
+// Tier stored in a snapshot; values this build does not know load as Standard
+static ClientTier tierFromByte(std::uint8_t value) {
+    return value < TIER_COUNT ? static_cast<ClientTier>(value) : ClientTier::STANDARD;
+}
+
+bool Blockchain::loadSnapshot(const std::string& filename) {
+    SnapshotReader reader;
+    if (!reader.open(filename)) {
+        std::cerr << filename << ": " << reader.getError() << "\n";
+        return false;
+    }
+
+    // Decoded objects are staged here and only attached once every section checked out
+    std::vector<std::string_view> strings;
+    struct StagedWallet {
+        std::size_t client;   // Index in loadedClients
+        std::string id;
+        Money balance;
+    };
+    struct StagedClient {
+        std::string id;
+        std::string name;
+        ClientTier tier;
+    };
+    std::vector<StagedClient> loadedClients;
+    std::vector<StagedWallet> loadedWallets;
+    std::vector<Transaction> loadedTransactions;
+    std::vector<BlockHeader> loadedBlocks;
+    bool ok = true;
+
+    // Version 1 stored amounts as doubles; they are rounded to the nearest cent
+    bool legacyAmounts = reader.getVersion() < 2;
+    bool timestamps = reader.getVersion() >= 3;  // Commit times were added in version 3
+    bool types = reader.getVersion() >= 4;       // Transaction types in version 4
+    bool currentMerkle = reader.getVersion() >= 5;  // Earlier blocks use the old Merkle tree and are re-sealed
+    auto amount = [&](ByteReader& in) -> Money {
+        return legacyAmounts ? static_cast<Money>(std::llround(in.getF64() * MONEY_SCALE)) : in.getI64();
+    };
+
+    auto str = [&](std::uint32_t index) -> std::string {
+        if (index >= strings.size()) {
+            ok = false;
+            return std::string();
+        }
+        return std::string(strings[index]);
+    };
+
+    std::uint32_t tag;
+    ByteReader in;
+    while (ok && reader.nextSection(tag, in)) {
+        if (tag == SECTION_STRINGS) {
+            std::uint32_t count = in.getU32();
+            strings.reserve(count);
+            for (std::uint32_t i = 0; i < count && in.good(); ++i) {
+                std::uint32_t length = in.getU32();
+                strings.push_back(in.getBytes(length));
+            }
+        } else if (tag == SECTION_CLIENTS) {
+            std::uint32_t count = in.getU32();
+            loadedClients.reserve(count);
+            for (std::uint32_t i = 0; i < count && in.good() && ok; ++i) {
+                std::string id = str(in.getU32());
+                std::string name = str(in.getU32());
+                loadedClients.push_back({std::move(id), std::move(name), tierFromByte(in.getU8())});
+
+                std::uint32_t walletCount = in.getU32();
+                for (std::uint32_t k = 0; k < walletCount && in.good() && ok; ++k) {
+                    std::string walletId = str(in.getU32());
+                    Money balance = amount(in);
+                    loadedWallets.push_back({loadedClients.size() - 1, std::move(walletId), balance});
+                }
+            }
+        } else if (tag == SECTION_TRANSACTIONS) {
+            std::uint64_t count = in.getU64();
+            loadedTransactions.reserve(static_cast<std::size_t>(count));
+            for (std::uint64_t i = 0; i < count && in.good() && ok; ++i) {
+                std::string id = str(in.getU32());
+                std::string sender = str(in.getU32());
+                std::string recipient = str(in.getU32());
+                Money value = amount(in);
+                Money commission = amount(in);
+                Timestamp timestamp = timestamps ? in.getI64() : 0;
+                TxType type = TxType::TRANSFER;
+                if (types && !txTypeFromCode(static_cast<char>(in.getU8()), type))
+                    ok = false;
+                loadedTransactions.emplace_back(std::move(id), std::move(sender), std::move(recipient),
+                                                value, type, commission, timestamp);
+            }
+        } else if (tag == SECTION_BLOCKS) {
+            std::uint64_t count = in.getU64();
+            for (std::uint64_t i = 0; i < count && in.good(); ++i) {
+                BlockHeader block;
+                block.index = in.getU64();
+                block.firstSlot = in.getU64();
+                block.txCount = in.getU32();
+                auto hash = [&](Hash256& out) {
+                    std::string_view bytes = in.getBytes(out.size());
+                    if (in.good()) std::copy(bytes.begin(), bytes.end(), out.begin());
+                };
+                hash(block.previousHash);
+                hash(block.merkleRoot);
+                hash(block.hash);
+                loadedBlocks.push_back(block);
+            }
+        }
+        // Unknown sections are skipped; known ones must be consumed exactly
+        bool known = tag == SECTION_STRINGS || tag == SECTION_CLIENTS || tag == SECTION_TRANSACTIONS ||
+                     tag == SECTION_BLOCKS;
+        if (!in.good() || (known && !in.atEnd()))
+            ok = false;
+    }
+    if (!reader.getError().empty())
+        ok = false;
+
+    if (!ok) {
+        std::cerr << filename << ": " << (reader.getError().empty() ? "corrupt snapshot" : reader.getError()) << "\n";
+        return false;
+    }
+
+    // A client already present keeps its wallets; the duplicate and its wallets are skipped
+    std::vector<Client*> added(loadedClients.size());
+    for (std::size_t i = 0; i < loadedClients.size(); ++i)
+        added[i] = addClient(loadedClients[i].id, loadedClients[i].name, loadedClients[i].tier);
+    std::size_t duplicateWallets = 0;
+    for (const StagedWallet& wallet : loadedWallets) {
+        if (added[wallet.client] && !createWallet(added[wallet.client], wallet.id, wallet.balance))
+            duplicateWallets++;
+    }
+    if (duplicateWallets > 0)
+        std::cerr << filename << ": skipped " << duplicateWallets << " wallet(s) with an ID already registered\n";
+    // Block slots are relative to an empty store, so blocks are only restored into one
+    bool restoreBlocks = transactions.getSlotCount() == 0 && blocks.empty();
+    transactions.reserve(loadedTransactions.size());
+    std::size_t duplicates = 0, outOfOrder = 0, invalid = 0;
+    Timestamp latest = rangeIndex.latest();
+    for (Transaction& tx : loadedTransactions) {
+        if (isCommitted(tx.getId())) {
+            duplicates++;
+            continue;
+        }
+        if (!validAmounts(tx.getAmount(), tx.getCommission())) {
+            invalid++;
+            continue;
+        }
+        if (!inTimeOrder(tx.getTimestamp(), latest)) {
+            outOfOrder++;
+            continue;
+        }
+        resolveWallets(tx);
+        transactions.addTransaction(std::move(tx));
+    }
+    indexHistory();
+    reportDuplicates(filename, duplicates);
+    if (outOfOrder > 0)
+        std::cerr << filename << ": skipped " << outOfOrder << " transaction(s) older than the one before them\n";
+    if (invalid > 0)
+        std::cerr << filename << ": skipped " << invalid << " transaction(s) with an invalid amount or commission\n";
+    if (restoreBlocks && !loadedBlocks.empty() && !currentMerkle)
+        std::cerr << filename << ": blocks use an older Merkle tree and will be sealed again\n";
+    if (restoreBlocks && !loadedBlocks.empty() && currentMerkle) {
+        sealedSlots = static_cast<std::size_t>(loadedBlocks.back().firstSlot + loadedBlocks.back().txCount);
+        blocks = std::move(loadedBlocks);
+    }
+    return true;
+}
+
+// Sync log: appended and handed to the OS before the caller gets its statuses.
+// Group-commit log: queued for the writer thread; logTicket tells when it is durable.
+void Blockchain::logCommitted(Transaction* const* txs, std::size_t count) {
+    if (count == 0) return;
+    bool written = true;
+    if (log.isOpen()) {
+        for (std::size_t i = 0; i < count && written; ++i)
+            written = log.append(*txs[i]);
+        written = written && log.flush();
+    } else if (groupLog.isOpen()) {
+        logTicket = groupLog.append(txs, count);
+        written = !groupLog.hasFailed();
+    }
+    if (!written && !logFailed) {
+        std::cerr << "Cannot write the transaction log: refusing further transactions\n";
+        logFailed = true;
+    }
+}
+
+bool Blockchain::openLog(const std::string& filename) {
+    groupLog.close();
+    return log.open(filename);
+}
+
+bool Blockchain::openGroupCommitLog(const std::string& filename, const GroupCommitConfig& config) {
+    log.close();
+    return groupLog.open(filename, config);
+}
+
+GroupCommitLog& Blockchain::getGroupCommitLog() {
+    return groupLog;
+}
+
+std::uint64_t Blockchain::getLogTicket() const {
+    return logTicket;
+}
+
+bool Blockchain::syncLog() {
+    if (logFailed) return false;
+    if (log.isOpen()) return log.sync();
+    if (groupLog.isOpen()) return groupLog.waitDurable(logTicket);
+    return false;
+}
+
+bool Blockchain::rotateLog(const std::string& filename) {
+    if (groupLog.isOpen()) return groupLog.reopen(filename);
+    if (!log.isOpen()) return false;
+    bool synced = log.sync();
+    return log.open(filename) && synced;
+}
+
+bool Blockchain::resetLog() {
+    // The caller saved a snapshot holding every commit, so an empty log matches the state again
+    bool reset = groupLog.isOpen() ? groupLog.reset() : log.reset();
+    if (reset)
+        logFailed = false;
+    return reset;
+}
+
+bool Blockchain::replayLog(const std::string& filename) {
+    LedgerParser parser;
+    if (!parser.open(filename)) return false;
+
+    std::string_view line;
+    std::size_t duplicates = 0;
+    Timestamp latest = rangeIndex.latest();
+    while (parser.nextLine(line)) {
+        TransactionRecord record;
+        if (!LedgerParser::parseTransactionRecord(line, record)) {
+            parser.reportError("malformed log record");
+            continue;
+        }
+        // Already in the loaded state (the log outlived the save that included it): applied once only
+        if (isCommitted(record.id)) {
+            duplicates++;
+            continue;
+        }
+        if (!inTimeOrder(record.timestamp, latest)) {
+            parser.reportError("cannot replay transaction " + std::string(record.id) +
+                               ": older than the one before it");
+            continue;
+        }
+
+        Transaction tx(std::string(record.id), std::string(record.senderWalletId),
+                       std::string(record.recipientWalletId), record.amount, record.type, record.commission,
+                       record.timestamp);
+        const WalletRef* sender;
+        const WalletRef* recipient;
+        TxStatus status = localWallets(tx, sender, recipient);
+        if (status == TxStatus::OK)
+            status = applyTransfer(&tx, sender, recipient);
+        if (status != TxStatus::OK) {
+            parser.reportError("cannot replay transaction " + tx.getId() + ": " + txStatusMessage(status));
+            continue;
+        }
+        transactions.addTransaction(std::move(tx));
+    }
+    indexHistory();
+    sealFullBlocks();
+
+    reportParseErrors(filename, parser);
+    reportDuplicates(filename, duplicates);
+    return true;
+}
+
+bool Blockchain::hasTransaction(const std::string& transactionId) const {
+    return isCommitted(transactionId);
+}
+
+void Blockchain::forEachCommittedId(const std::function<void(const std::string&)>& visit) const {
+    transactions.forEach([&](const Transaction& tx) { visit(tx.getId()); });
+}
+
+Client* Blockchain::findClientById(const std::string& clientId) const {
+    return clients.find(clientIds.find(clientId));
+}
+
+std::vector<Client*> Blockchain::getTopClients(std::size_t n) const {
+    return clients.topN(n);
+}
+
+std::size_t Blockchain::getClientRank(const std::string& clientId) const {
+    return clients.rankOf(clientIds.find(clientId));
+}
+
 ClientNode* Blockchain::getRoot() const {
     return clients.getRoot();
 }
 
-// Implémentation de la nouvelle méthode indexWallet
-void Blockchain::indexWallet(Wallet* wallet) {
-    walletIndex[wallet->getId()] = wallet;
+void Blockchain::indexWallet(Wallet* wallet, Client* owner, IdHandle handle) {
+    WalletRef ref{wallet, owner, owner ? owner->getTier() : ClientTier::STANDARD};
+    wallet->setHandle(handle);
+    if (handle >= walletIndex.size())
+        walletIndex.resize(handle + 1, WalletRef{nullptr, nullptr, ClientTier::STANDARD});
+    walletIndex[handle] = ref;
+    // A new wallet changes the owner's total balance
+    if (owner)
+        clients.updateBalance(owner);
 }
@@ -1,38 +1,278 @@
 #ifndef BLOCKCHAIN_H
 #define BLOCKCHAIN_H
 
+#include "Block.h"
 #include "ClientBST.h"
+#include "GroupCommitLog.h"
+#include "IdTable.h"
+#include "LedgerMetrics.h"
+#include "ObjectPool.h"
+#include "RangeIndex.h"
 #include "TransactionList.h"
+#include "TransactionLog.h"
+#include "TxStatus.h"
 #include "Wallet.h"
+#include "WorkerPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
+
+class IdArchive;
+struct SnapshotSection;
+class StringTable;
+
+// Outcome of Blockchain::verifyLedger
+struct VerificationReport {
+    bool ok;                          // True if no divergence was found
+    std::size_t transactionsChecked;  // Transactions replayed
+    std::size_t blocksChecked;        // Block headers re-hashed
+    std::string divergence;           // Earliest transaction that does not replay, empty if none
+    std::string blockDivergence;      // Earliest block whose hashes or links do not match, empty if none
+};
+
+// Counters of a transaction file streamed through Blockchain::processTransactionFile
+struct ReplayStats {
+    std::size_t accepted;   // Transactions committed
+    std::size_t rejected;   // Well-formed transactions that failed validation
+    std::size_t malformed;  // Lines that are not transaction records
+    std::size_t duplicates; // Records whose transaction ID was already committed
+};
+
+// Entry of the wallet index: resolves a wallet handle straight to the wallet and its owner
+struct WalletRef {
+    Wallet* wallet;      // Indexed wallet
+    Client* owner;       // Client owning the wallet (nullptr if the owner is unknown)
+    ClientTier tier;     // Tier of the owner, cached for the transaction path
+};
 
 class Blockchain {
 private:
-    ClientBST clients;
+    ObjectPool<Client> clientPool;        // Storage of every client
+    ObjectPool<Wallet> walletPool;        // Storage of every wallet
+    IdTable clientIds;                    // Client ID <-> handle
+    IdTable clientNames;                  // Client names, interned so clients hold no strings of their own
+    IdTable walletIds;                    // Wallet ID <-> handle
+    ClientBST clients;                    // Keyed by client handle
     TransactionList transactions;
-    std::unordered_map<std::string, Wallet*> walletIndex;
+    const IdArchive* idArchive;           // IDs of compacted log segments, checked after transactions (optional)
+    std::vector<WalletRef> walletIndex;   // Wallet handle -> wallet (wallet is nullptr if not indexed)
+    TransactionLog log;                   // Write-ahead log of committed transactions (optional)
+    GroupCommitLog groupLog;              // Group-commit alternative to log (optional, one of the two)
+    std::uint64_t logTicket;              // groupLog ticket of the latest committed transaction
+    bool logFailed;                       // A log write failed: commits are refused until resetLog()
+    std::unique_ptr<WorkerPool> workers;  // Shared by batches, seals and audits; created on first use, only grows
+    std::vector<BlockHeader> blocks;      // Sealed blocks, in chain order
+    std::size_t sealedSlots;              // Transaction slots covered by the sealed blocks
+    std::size_t blockSize;                // Transactions per automatically sealed block
+    LedgerMetrics metrics;                // Outcome counters and latency histograms
+    std::vector<std::vector<std::uint64_t>> walletHistory; // Wallet handle -> slots it sent or received, oldest first
+    std::size_t historySlots;             // Transaction slots already added to walletHistory and rangeIndex
+    RangeIndex rangeIndex;                // Commit times and amounts by slot, for range queries
+
+    // Workers a call asks for: threadCount, or one per hardware thread for 0
+    static std::size_t participantsFor(std::size_t threadCount);
+    // Returns the worker pool with at least that many workers. It starts with one per hardware
+    // thread and is only replaced to grow, so calls asking for different counts share it and
+    // cap their participants instead of rebuilding it.
+    WorkerPool& getWorkers(std::size_t participants);
+
+    // Seals the slot range [firstSlot, firstSlot + count) into blocks of at most maxPerBlock
+    // transactions; leaf hashes of the whole range are computed in parallel
+    void sealSlots(std::size_t firstSlot, std::size_t count, std::size_t maxPerBlock);
+
+    // Seals every complete block worth of committed transactions
+    void sealFullBlocks();
+
+    // Appends committed transactions to whichever write-ahead log is open. A failed write latches
+    // logFailed: the log no longer replays to the live state, so nothing more may commit on it.
+    void logCommitted(Transaction* const* txs, std::size_t count);
+    // Statuses of a batch refused because logFailed is set
+    std::vector<TxStatus> refuseUnlogged(std::size_t count);
+
+    // CLNT section of a snapshot: clients with tiers, wallets and balances. With shareIds, client
+    // and wallet IDs are interned so later sections can refer to the same strings.
+    SnapshotSection encodeClients(StringTable& strings, bool shareIds) const;
+
+    // Indexes a wallet under a known owner at the free index entry of its interned ID
+    void indexWallet(Wallet* wallet, Client* owner, IdHandle handle);
+
+    // Translates the wallet IDs of an incoming transaction to handles, once per transaction
+    void resolveWallets(Transaction& tx) const;
+
+    // Resolves the wallets a transaction moves in this ledger: both for a transfer, only the sender
+    // of a debit half and only the recipient of a credit half (the other one is left nullptr).
+    // WALLET_NOT_FOUND if one it needs is not indexed.
+    TxStatus localWallets(Transaction& tx, const WalletRef*& sender, const WalletRef*& recipient) const;
+
+    // Checks the sender's owner, limit and balance; reads the sender wallet only (none for a credit half)
+    TxStatus validateTransfer(const Transaction& tx, const WalletRef* sender) const;
+
+    // Withdraws amount + commission from the sender and deposits the amount, on the wallets that
+    // are given; WITHDRAW_FAILED if refused
+    TxStatus moveFunds(const Transaction& tx, const WalletRef* sender, const WalletRef* recipient);
+
+    // validateTransfer + moveFunds; touches nothing but the two wallets
+    TxStatus transferFunds(const Transaction& tx, const WalletRef* sender, const WalletRef* recipient);
+
+    // Adds the transactions appended to the store since the last call to the wallet histories
+    // and the range index
+    void indexHistory();
+
+    // Current time for a commit, never earlier than the last indexed commit
+    Timestamp commitTime() const;
+
+    // Transactions of the slots, skipping empty slots
+    std::vector<const Transaction*> transactionsAt(const std::vector<std::size_t>& slots) const;
+
+    // True (and latest moves up to it) unless a loaded record is older than latest, the time of the
+    // record before it; loaders skip the records that are not
+    static bool inTimeOrder(Timestamp time, Timestamp& latest);
+
+    // Repositions the owners of the two wallets in the client index after their totals changed
+    void repositionOwners(const WalletRef* sender, const WalletRef* recipient);
+
+    // True if a transaction with this ID was committed: in the store or before the loaded checkpoint
+    bool isCommitted(std::string_view id) const;
+
+    // Marks as DUPLICATE_ID the transactions of a batch whose ID is already committed or appears
+    // earlier in the batch
+    void markDuplicates(Transaction* const* txs, std::size_t count, std::vector<TxStatus>& statuses) const;
+
+    // Validates a transfer, moves the funds and updates the client index; does not record the transaction
+    TxStatus applyTransfer(Transaction* tx, const WalletRef* sender, const WalletRef* recipient);
 
 public:
     Blockchain();
     ~Blockchain();
 
-    void addClient(Client* client);
-    bool processTransaction(Transaction* tx);
+    // Creates a client in the client pool and indexes it; nullptr (nothing added) if the client ID exists
+    Client* addClient(std::string_view clientId, std::string_view name, ClientTier tier);
+    // Creates a wallet in the wallet pool, lists it under an added client and indexes it;
+    // nullptr (nothing created) if the wallet ID is already registered to a client
+    Wallet* createWallet(Client* owner, std::string_view walletId, Money balance);
+    bool processTransaction(Transaction* tx); // Takes ownership if accepted; a rejected transaction stays with the caller
+    // Same checks and commit without a heap object: an accepted transaction is moved into the
+    // store, a rejected one is left untouched. Nothing is printed; the status says why it was rejected.
+    // Intake is idempotent: an ID already in the store is rejected as DUPLICATE_ID before any
+    // balance is read or changed.
+    TxStatus processTransaction(Transaction&& tx);
+
+    // Streams a transaction file ("id;sender;recipient;amount;commission[;timestamp]" lines) through
+    // processTransaction one record at a time. False if the file cannot be opened.
+    bool processTransactionFile(const std::string& filename, ReplayStats& stats);
+
+    // Validates and applies a contiguous batch of transactions in one pass.
+    // Accepted transactions are appended to the list in a single step and owned by the blockchain;
+    // rejected ones stay owned by the caller. Returns one status per input transaction.
+    // An ID already stored, or repeated within the batch, is a DUPLICATE_ID from its second occurrence on.
+    std::vector<TxStatus> processTransactions(Transaction* const* txs, std::size_t count);
+
+    // Same contract and same result as processTransactions, but transfers run on a pool of
+    // threadCount workers (0 = one per hardware thread). The batch is split into waves of
+    // transfers on disjoint wallets, in input order per wallet; each wave runs in parallel, the
+    // waves one after another. Accepted transactions are recorded (and logged) in input order,
+    // which replays to the same state. Must not run concurrently with other calls.
+    std::vector<TxStatus> processTransactionsParallel(Transaction* const* txs, std::size_t count,
+                                                      std::size_t threadCount = 0);
     void displayClients() const;
     void displayTransactions() const;
 
     bool saveClientsToFile(const std::string& filename) const;
     bool loadClientsFromFile(const std::string& filename);
     bool saveTransactionsToFile(const std::string& filename) const;
-    bool loadTransactionsFromFile(const std::string& filename);
+    bool loadTransactionsFromFile(const std::string& filename);  // Skips (and reports) IDs already stored
+
+    // Binary snapshot of the whole state (clients, wallets, transaction log), see Snapshot.h.
+    // saveSnapshot replaces the file atomically (see replaceSnapshotFile), so a crash keeps the old one.
+    // loadSnapshot is meant for an empty blockchain at startup; nothing is applied if the file is corrupt.
+    // Transactions whose ID is already stored are skipped and reported.
+    bool saveSnapshot(const std::string& filename) const;
+    bool loadSnapshot(const std::string& filename);
+    // Balances-only snapshot for a checkpoint: clients and wallets, and a CKPT section naming the
+    // first log segment it does not cover. Transactions and blocks are left out, so loading it
+    // (with loadSnapshot) restores balances without history; the IDs it leaves out are kept apart,
+    // see setIdArchive. The caller writes the sections.
+    void captureCheckpoint(std::uint64_t firstTailSegment, std::vector<SnapshotSection>& sections) const;
+    // IDs committed before the loaded checkpoint, rejected as duplicates like the stored ones
+    // (nullptr for none). The archive must outlive the ledger or be detached first.
+    void setIdArchive(const IdArchive* archive);
+
+    // Blocks: committed transactions are grouped into blocks of getBlockSize() transactions as
+    // they commit; each block carries a Merkle root over its transaction hashes and the hash of
+    // the previous block header.
+    void setBlockSize(std::size_t size);
+    std::size_t getBlockSize() const;
+    bool sealBlock();                                 // Seals pending transactions into a (partial) block
+    const std::vector<BlockHeader>& getBlocks() const;
+    bool saveBlocksToFile(const std::string& filename) const;
+    bool loadBlocksFromFile(const std::string& filename); // Headers for the transactions already loaded
+
+    // Audits the loaded state: the transaction log is replayed against the current wallet
+    // balances (opening balance = current balance minus the log's net effect) and every transfer
+    // must pass the limit and funds checks in log order; sealed blocks are re-hashed and their
+    // links checked. Work is split across threadCount workers (0 = hardware threads) by wallet
+    // shard for the replay and by block range for the hashes.
+    VerificationReport verifyLedger(std::size_t threadCount = 0);
+
+    // History of one wallet (sent and received), newest first: skips `offset` transactions and
+    // returns at most `limit`, in O(offset + limit). Unknown wallets have an empty history.
+    std::vector<const Transaction*> getWalletHistory(const std::string& walletId, std::size_t offset,
+                                                     std::size_t limit) const;
+    std::size_t getWalletHistorySize(const std::string& walletId) const;
+
+    // Range queries over commit times (see Transaction::getTimestamp), both bounds inclusive,
+    // results in commit order, on the range index instead of a scan of the store: O(log n + k)
+    // for k transactions in the window, O(log n + k log(n / k)) for k transfers above an amount.
+    // Transactions loaded from files without timestamps count as committed at 0.
+    std::vector<const Transaction*> getTransactionsBetween(Timestamp from, Timestamp to) const;
+    // Transfers of more than amount committed in [from, to]
+    std::vector<const Transaction*> getTransfersAbove(Money amount, Timestamp from, Timestamp to) const;
+
+    // Metrics: transaction outcomes (all intake paths), validate/apply latency (processTransaction)
+    // and structure sizes. Cheap enough to stay on; see LedgerMetrics.h.
+    MetricsSnapshot getMetrics() const;
+    void resetMetrics();
+    void dumpMetrics(std::ostream& out) const;
+
+    // Write-ahead log: once opened, every committed transaction is appended and flushed
+    // before processTransaction/processTransactions return. If a write fails (or the group-commit
+    // writer reports a failure), the transactions of that call stay applied in memory, syncLog()
+    // returns false and every later transaction is refused as LOG_FAILED, until a snapshot is
+    // saved and resetLog() starts the sync log over (a failed group-commit log stays failed).
+    bool openLog(const std::string& filename);
+    // Group-commit write-ahead log, instead of openLog: commits are queued to a writer thread that
+    // writes and fsyncs them in groups, so processTransaction(s) return before they are durable.
+    // A commit is durable once getGroupCommitLog().getDurable() reaches getLogTicket() as read
+    // right after it (or after syncLog()).
+    bool openGroupCommitLog(const std::string& filename, const GroupCommitConfig& config);
+    GroupCommitLog& getGroupCommitLog();
+    std::uint64_t getLogTicket() const;               // Group-commit ticket of the latest commit
+    bool syncLog();                                   // Blocks until every commit so far is on disk
+    bool rotateLog(const std::string& filename);      // Syncs the open log and continues it in a new file
+    bool resetLog();                                  // Empties the log after a full save
+    // Re-applies logged transactions to the loaded wallets, in log order.
+    // Call it on the state the log was started from, before openLog; records whose transaction
+    // is already stored are skipped, so replaying onto a state that includes them is harmless.
+    bool replayLog(const std::string& filename);
 
     Wallet* findWalletById(const std::string& walletId) const;
+    const WalletRef* findWalletRef(const std::string& walletId) const;  // Wallet with its owner and tier
+    const WalletRef* findWalletRef(IdHandle walletHandle) const;        // Same, by interned handle
+    Client* findClientByWallet(const std::string& walletId) const;      // Owner of a wallet, O(1)
 
-    ClientNode* getRoot() const;
+    bool hasTransaction(const std::string& transactionId) const;       // True if the ID was committed
+    // Visits the ID of every stored transaction (not those of the ID archive)
+    void forEachCommittedId(const std::function<void(const std::string&)>& visit) const;
 
-    // Nouvelle méthode pour indexer un wallet
-    void indexWallet(Wallet* wallet);
+    Client* findClientById(const std::string& clientId) const;
+    std::vector<Client*> getTopClients(std::size_t n) const;    // Richest clients first
+    std::size_t getClientRank(const std::string& clientId) const; // 1 = highest total balance
+
+    ClientNode* getRoot() const;
 };
 
 #endif // BLOCKCHAIN_H
@@ -0,0 +1,53 @@
+#include "BloomFilter.h"
+
+// Second hash for the bit positions, independent of the bits that pick the block
+static std::uint64_t remix(std::uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+BloomFilter::BloomFilter() {}
+
+std::size_t BloomFilter::blockIndex(std::uint64_t hash, std::size_t blockCount) {
+    return static_cast<std::size_t>(((hash >> 32) * static_cast<std::uint64_t>(blockCount)) >> 32);
+}
+
+void BloomFilter::reset(std::size_t expectedKeys) {
+    std::size_t count = (expectedKeys * BITS_PER_KEY + 511) / 512;
+    blocks.assign(count > 0 ? count : 1, Block{});
+}
+
+void BloomFilter::add(std::uint64_t hash) {
+    if (blocks.empty())
+        reset(1024);
+    Block& block = blocks[blockIndex(hash, blocks.size())];
+    std::uint64_t bits = remix(hash);
+    for (unsigned i = 0; i < PROBES; ++i, bits >>= 9)
+        block.words[(bits >> 6) & 7] |= 1ULL << (bits & 63);
+}
+
+bool BloomFilter::mayContain(std::uint64_t hash) const {
+    return mayContain(getWords(), blocks.size(), hash);
+}
+
+std::size_t BloomFilter::getBlockCount() const {
+    return blocks.size();
+}
+
+const std::uint64_t* BloomFilter::getWords() const {
+    return blocks.empty() ? nullptr : blocks.front().words;
+}
+
+bool BloomFilter::mayContain(const std::uint64_t* words, std::size_t blockCount, std::uint64_t hash) {
+    if (blockCount == 0)
+        return false;
+    const std::uint64_t* block = words + blockIndex(hash, blockCount) * BLOCK_WORDS;
+    std::uint64_t bits = remix(hash);
+    for (unsigned i = 0; i < PROBES; ++i, bits >>= 9) {
+        if (!(block[(bits >> 6) & 7] & (1ULL << (bits & 63))))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Blocked Bloom filter over 64-bit key hashes.
+// All the bits of a key fall in one 64-byte block, so a membership test reads a single cache
+// line wherever the filter is in memory. Sized at BITS_PER_KEY bits per expected key (about 1.5%
+// false positives at full load), which is 125 MB for 10^8 keys. Keys cannot be removed.
+class BloomFilter {
+private:
+    struct alignas(64) Block {
+        std::uint64_t words[8];  // BLOCK_WORDS
+    };
+
+    static const std::size_t BITS_PER_KEY = 10;
+    static const unsigned PROBES = 6;  // Bits set per key
+
+    std::vector<Block> blocks;
+
+    // Block of a hash, mapped onto the block count without a division
+    static std::size_t blockIndex(std::uint64_t hash, std::size_t blockCount);
+
+public:
+    BloomFilter();
+
+    // Empties the filter and sizes it for expectedKeys keys
+    void reset(std::size_t expectedKeys);
+
+    void add(std::uint64_t hash);
+    bool mayContain(std::uint64_t hash) const;  // False means the key was never added
+
+    // Stored form: getBlockCount() blocks of BLOCK_WORDS words each, starting at getWords()
+    static const std::size_t BLOCK_WORDS = 8;
+    std::size_t getBlockCount() const;
+    const std::uint64_t* getWords() const;
+    // mayContain() on blocks stored elsewhere (such as a mapped file) in the layout of getWords()
+    static bool mayContain(const std::uint64_t* words, std::size_t blockCount, std::uint64_t hash);
+};
+
+#endif // BLOOMFILTER_H
@@ -0,0 +1,215 @@
+#include "CheckpointManager.h"
+#include "LedgerParser.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <utility>
+
+// Digits of the file numbers, so the files also sort by name
+static const std::size_t NUMBER_WIDTH = 6;
+
+static std::string fileNumber(std::uint64_t n) {
+    std::string digits = std::to_string(n);
+    return digits.size() < NUMBER_WIDTH ? std::string(NUMBER_WIDTH - digits.size(), '0') + digits : digits;
+}
+
+// Reads the first log segment a checkpoint does not cover from its CKPT section
+static bool readCheckpointSegment(const std::string& filename, std::uint64_t& segment) {
+    SnapshotReader reader;
+    std::uint32_t tag;
+    ByteReader in;
+    if (!reader.open(filename) || !reader.nextSection(tag, in) || tag != SECTION_CHECKPOINT)
+        return false;
+    segment = in.getU64();
+    in.getI64();
+    return in.good() && in.atEnd();
+}
+
+CheckpointManager::CheckpointManager(Blockchain& ledger, std::string prefix, const CheckpointConfig& config)
+    : ledger(ledger), prefix(std::move(prefix)), config(config), segment(0), slotsAtCheckpoint(0),
+      writeFailed(false), archive(this->prefix), archiveWriter(this->prefix) {}
+
+CheckpointManager::~CheckpointManager() {
+    wait();
+    ledger.setIdArchive(nullptr);
+}
+
+std::string CheckpointManager::segmentFile(std::uint64_t n) const {
+    return prefix + "wal_" + fileNumber(n) + ".txt";
+}
+
+std::string CheckpointManager::checkpointFile(std::uint64_t n) const {
+    return prefix + "checkpoint_" + fileNumber(n) + ".snapshot";
+}
+
+std::vector<std::uint64_t> CheckpointManager::listFiles(const std::string& stem, const std::string& suffix) const {
+    std::filesystem::path pattern(prefix + stem);
+    std::filesystem::path directory = pattern.parent_path();
+    const std::string start = pattern.filename().string();
+
+    std::vector<std::uint64_t> numbers;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator entry(directory.empty() ? "." : directory, ec), end;
+         !ec && entry != end; entry.increment(ec)) {
+        std::string name = entry->path().filename().string();
+        if (name.size() <= start.size() + suffix.size() || name.compare(0, start.size(), start) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+            continue;
+        std::string digits = name.substr(start.size(), name.size() - start.size() - suffix.size());
+        if (digits.find_first_not_of("0123456789") == std::string::npos)
+            numbers.push_back(std::strtoull(digits.c_str(), nullptr, 10));
+    }
+    std::sort(numbers.begin(), numbers.end());
+    return numbers;
+}
+
+bool CheckpointManager::openLog(const std::string& filename) {
+    return config.groupCommit ? ledger.openGroupCommitLog(filename, config.group) : ledger.openLog(filename);
+}
+
+bool CheckpointManager::recover(const std::string& baseClientsFile) {
+    std::vector<std::uint64_t> checkpoints = listFiles("checkpoint_", ".snapshot");
+    std::vector<std::uint64_t> segments = listFiles("wal_", ".txt");
+
+    // Newest checkpoint that reads back; loadSnapshot applies nothing from a corrupt file
+    bool loaded = false;
+    std::uint64_t from = segments.empty() ? 0 : segments.front();
+    for (auto n = checkpoints.rbegin(); n != checkpoints.rend() && !loaded; ++n) {
+        std::uint64_t covered;
+        if (readCheckpointSegment(checkpointFile(*n), covered) && covered == *n &&
+            ledger.loadSnapshot(checkpointFile(*n))) {
+            loaded = true;
+            from = *n;
+        } else {
+            std::cerr << checkpointFile(*n) << ": unreadable checkpoint, trying an older one\n";
+        }
+    }
+    if (!loaded) {
+        // Without a checkpoint the log must still start at the first segment
+        if (segments.empty() ? !checkpoints.empty() : segments.front() > 0) {
+            std::cerr << prefix << ": no readable checkpoint and the log segments before it are gone\n";
+            return false;
+        }
+        if (!baseClientsFile.empty() && !ledger.loadClientsFromFile(baseClientsFile)) {
+            std::cerr << "Cannot read " << baseClientsFile << "\n";
+            return false;
+        }
+    }
+
+    // Segments a compaction did not get to are archived first; an unreadable run loses only the
+    // duplicate check of its IDs, so recovery goes on
+    archiveWriter.open();
+    bool archived = !loaded || archiveSegments(from);
+
+    // Replay only the tail the checkpoint does not cover. The archive is attached afterwards: if
+    // an older checkpoint was loaded, it holds IDs of segments that are replayed now
+    segment = from;
+    for (std::uint64_t n : segments) {
+        if (n < from) continue;
+        ledger.replayLog(segmentFile(n));
+        segment = n;
+    }
+    slotsAtCheckpoint = ledger.getMetrics().transactionSlots;
+    archive.open();
+    ledger.setIdArchive(&archive);
+
+    // Leftovers of a checkpoint interrupted before its rename, and files it made redundant
+    for (std::uint64_t n : listFiles("checkpoint_", ".snapshot.tmp")) {
+        std::error_code ec;
+        std::filesystem::remove(checkpointFile(n) + ".tmp", ec);
+    }
+    if (loaded && archived)
+        compact(from);
+    return openLog(segmentFile(segment));
+}
+
+bool CheckpointManager::checkpoint() {
+    wait();  // One checkpoint at a time
+    std::uint64_t next = segment + 1;
+    if (!ledger.rotateLog(segmentFile(next)))
+        return false;
+    segment = next;
+
+    // Captured here, while no commit runs; the slow part (write, sync, compaction) runs behind
+    std::vector<SnapshotSection> sections;
+    ledger.captureCheckpoint(next, sections);
+    slotsAtCheckpoint = ledger.getMetrics().transactionSlots;
+    writer = std::thread([this, next, captured = std::move(sections)]() {
+        writeFailed = !writeCheckpoint(captured, next);
+    });
+    return true;
+}
+
+bool CheckpointManager::maybeCheckpoint() {
+    if (config.everyTransactions == 0 ||
+        ledger.getMetrics().transactionSlots - slotsAtCheckpoint < config.everyTransactions)
+        return false;
+    return checkpoint();
+}
+
+bool CheckpointManager::wait() {
+    if (writer.joinable())
+        writer.join();
+    return !writeFailed;
+}
+
+std::uint64_t CheckpointManager::getSegment() const {
+    return segment;
+}
+
+bool CheckpointManager::writeCheckpoint(const std::vector<SnapshotSection>& sections, std::uint64_t n) {
+    const std::string filename = checkpointFile(n);
+    if (!replaceSnapshotFile(filename, sections)) {
+        std::cerr << filename << ": cannot write checkpoint\n";
+        return false;
+    }
+    // Without their IDs archived the segments stay, and recover() archives them
+    if (!archiveSegments(n))
+        return false;
+    compact(n);
+    return true;
+}
+
+bool CheckpointManager::archiveSegments(std::uint64_t n) {
+    std::uint64_t first = archiveWriter.getEnd();
+    if (first >= n)
+        return true;
+    std::vector<std::string> ids;
+    for (std::uint64_t old : listFiles("wal_", ".txt")) {
+        if (old < first || old >= n) continue;
+        LedgerParser parser;
+        if (!parser.open(segmentFile(old))) {
+            std::cerr << segmentFile(old) << ": cannot read log segment to archive its IDs\n";
+            return false;
+        }
+        std::string_view line;
+        TransactionRecord record;
+        while (parser.nextLine(line)) {
+            if (LedgerParser::parseTransactionRecord(line, record))
+                ids.emplace_back(record.id);
+        }
+    }
+    return archiveWriter.addRun(first, n, std::move(ids));
+}
+
+void CheckpointManager::compact(std::uint64_t n) {
+    std::error_code ec;
+    for (std::uint64_t old : listFiles("checkpoint_", ".snapshot")) {
+        if (old < n)
+            std::filesystem::remove(checkpointFile(old), ec);
+    }
+    std::filesystem::path archive(prefix + "archive");
+    if (config.archive)
+        std::filesystem::create_directories(archive, ec);
+    for (std::uint64_t old : listFiles("wal_", ".txt")) {
+        if (old >= n) continue;
+        std::filesystem::path file(segmentFile(old));
+        if (config.archive)
+            std::filesystem::rename(file, archive / file.filename(), ec);
+        else
+            std::filesystem::remove(file, ec);
+    }
+}
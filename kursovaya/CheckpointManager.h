@@ -0,0 +1,78 @@
+#ifndef CHECKPOINTMANAGER_H
+#define CHECKPOINTMANAGER_H
+
+#include "Blockchain.h"
+#include "GroupCommitLog.h"
+#include "IdArchive.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// How the write-ahead log is written and how often checkpoints are taken
+struct CheckpointConfig {
+    std::size_t everyTransactions = 100000;  // maybeCheckpoint() checkpoints after this many commits (0 = never)
+    bool groupCommit = false;                // Group-commit log (see GroupCommitLog) instead of the sync one
+    GroupCommitConfig group;                 // Used with groupCommit
+    bool archive = false;                    // Move compacted segments to P + "archive/" instead of deleting them
+};
+
+// Checkpoints with log compaction for a Blockchain.
+// The write-ahead log is split into numbered segments, P + "wal_<n>.txt". A checkpoint switches
+// the log to a new segment n, captures a balances-only snapshot of the ledger (see
+// Blockchain::captureCheckpoint) and writes it to P + "checkpoint_<n>.snapshot" on a background
+// thread. The same thread then writes the transaction IDs of the segments the checkpoint covers
+// to the ID archive (see IdArchive), and only then deletes (or archives) the older checkpoints
+// and the segments before n. Checkpoint n and the archive thus cover every commit of the
+// segments before n, whatever step a crash interrupts.
+// recover() loads the newest checkpoint that reads back, or the base clients file when there is
+// none, and replays only the segments from there on, so startup time follows the log tail, not
+// the whole history. A checkpoint keeps no transaction history; the ledger checks the ID archive,
+// which is mapped rather than read, so the IDs committed before it are still rejected as
+// duplicates after a restart. The commit thread only ever encodes the balances.
+// Not thread-safe: all calls come from the thread that commits to the ledger.
+class CheckpointManager {
+private:
+    Blockchain& ledger;
+    std::string prefix;                  // Path prefix of the segment and checkpoint files
+    CheckpointConfig config;
+    std::uint64_t segment;               // Segment the log is writing
+    std::size_t slotsAtCheckpoint;       // Ledger transaction slots at the last checkpoint or recovery
+    std::thread writer;                  // Writes the latest checkpoint
+    std::atomic<bool> writeFailed;       // The latest checkpoint could not be written
+    IdArchive archive;                   // Checked by the ledger (commit thread), as opened by recover()
+    IdArchive archiveWriter;             // Extended by the checkpoint thread
+
+    std::string segmentFile(std::uint64_t n) const;
+    std::string checkpointFile(std::uint64_t n) const;
+    // Numbers of the existing files named prefix + stem + "<n>" + suffix, ascending
+    std::vector<std::uint64_t> listFiles(const std::string& stem, const std::string& suffix) const;
+    bool openLog(const std::string& filename);
+    // Writes checkpoint n, then drops what it makes redundant (background thread)
+    bool writeCheckpoint(const std::vector<SnapshotSection>& sections, std::uint64_t n);
+    // Adds the IDs of the segments before n that archiveWriter does not hold yet
+    bool archiveSegments(std::uint64_t n);
+    void compact(std::uint64_t n);       // Removes the checkpoints and segments older than n
+
+public:
+    CheckpointManager(Blockchain& ledger, std::string prefix, const CheckpointConfig& config);
+    ~CheckpointManager();                // Waits for a checkpoint being written, detaches the archive
+
+    CheckpointManager(const CheckpointManager&) = delete;
+    CheckpointManager& operator=(const CheckpointManager&) = delete;
+
+    // Startup on an empty ledger: loads the newest readable checkpoint (or baseClientsFile, if not
+    // empty, when there is none), replays the log tail and opens the log on its last segment.
+    // False if the state cannot be rebuilt (the segments older than a lost checkpoint are gone).
+    bool recover(const std::string& baseClientsFile);
+
+    bool checkpoint();                   // Starts a checkpoint now; false if the log cannot switch segments
+    bool maybeCheckpoint();              // Checkpoints if everyTransactions commits happened since the last one
+    bool wait();                         // Waits for the checkpoint being written; false if it failed
+
+    std::uint64_t getSegment() const;
+};
+
+#endif // CHECKPOINTMANAGER_H
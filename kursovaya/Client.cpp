@@ -1,73 +1,71 @@
 #include "Client.h"
 
-Client::Client(const std::string& id, const std::string& name)
-    : Entity(id), name(name) {}
-
-Client::~Client() {
-    // Wallets are destroyed by EntityVector destructor
-}
+Client::Client(const std::string& id, const std::string& name, ClientTier tier)
+    : id(&id), handle(NO_HANDLE), name(&name), tier(tier), totalBalance(0), firstWallet(nullptr),
+      lastWallet(nullptr), walletCount(0) {}
 
+// The wallet's balance joins the total, and the wallet reports its later changes to this client
 void Client::addWallet(Wallet* wallet) {
-    wallets.addEntity(wallet);
+    wallet->setNextOfOwner(nullptr);
+    if (lastWallet)
+        lastWallet->setNextOfOwner(wallet);
+    else
+        firstWallet = wallet;
+    lastWallet = wallet;
+    walletCount++;
+    wallet->setOwner(this);
+    adjustTotalBalance(wallet->getBalance());
 }
 
-double Client::getTotalBalance() const {
-    double total = 0.0;
-    const auto& walletEntities = wallets.getAllEntities();
-    for (Entity* e : walletEntities) {
-        Wallet* w = dynamic_cast<Wallet*>(e);
-        if (w) total += w->getBalance();
+bool Client::removeWallet(const std::string& walletId) {
+    Wallet* previous = nullptr;
+    Wallet* wallet = firstWallet;
+    while (wallet && wallet->getId() != walletId) {
+        previous = wallet;
+        wallet = wallet->getNextOfOwner();
     }
-    return total;
+    if (!wallet)
+        return false;
+    if (previous)
+        previous->setNextOfOwner(wallet->getNextOfOwner());
+    else
+        firstWallet = wallet->getNextOfOwner();
+    if (lastWallet == wallet)
+        lastWallet = previous;
+    walletCount--;
+    wallet->setNextOfOwner(nullptr);
+    wallet->setOwner(nullptr);
+    adjustTotalBalance(-wallet->getBalance());
+    return true;
 }
 
-std::string Client::getId() const {
-    return id;
+Money Client::getTotalBalance() const {
+    return totalBalance.load(std::memory_order_relaxed);
 }
 
-std::string Client::getName() const {
-    return name;
+const std::string& Client::getName() const {
+    return *name;
 }
 
-const EntityVector& Client::getWallets() const {
-    return wallets;
-}
+// ----------- Tier helpers -----------
 
-// ----------- StandardClient implementation -----------
-
-StandardClient::StandardClient(const std::string& id, const std::string& name)
-    : Client(id, name) {}
-
-double StandardClient::calculateCommission(double amount) const {
-    return amount * 0.05;
+bool tierFromName(std::string_view name, ClientTier& tier) {
+    for (const TierPolicy& policy : TIER_POLICIES) {
+        if (name == policy.name) {
+            tier = policy.tier;
+            return true;
+        }
+    }
+    return false;
 }
 
-double StandardClient::getMaxTransactionLimit() const {
-    return 1000.0;
-}
+// ----------- Tier shorthands -----------
 
-// ----------- GoldClient implementation -----------
+StandardClient::StandardClient(const std::string& id, const std::string& name)
+    : Client(id, name, ClientTier::STANDARD) {}
 
 GoldClient::GoldClient(const std::string& id, const std::string& name)
-    : Client(id, name) {}
-
-double GoldClient::calculateCommission(double amount) const {
-    return amount * 0.01;
-}
-
-double GoldClient::getMaxTransactionLimit() const {
-    return 10000.0;
-}
-
-// ----------- PlatinumClient implementation -----------
+    : Client(id, name, ClientTier::GOLD) {}
 
 PlatinumClient::PlatinumClient(const std::string& id, const std::string& name)
-    : Client(id, name) {}
-
-double PlatinumClient::calculateCommission(double amount) const {
-    return amount * 0.02;
-}
-
-double PlatinumClient::getMaxTransactionLimit() const {
-    return 5000.0;
-}
+    : Client(id, name, ClientTier::PLATINUM) {}
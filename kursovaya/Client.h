@@ -1,53 +1,118 @@
 #ifndef CLIENT_H
 #define CLIENT_H
 
-#include "Entity.h"
-#include "EntityVector.h"
+#include "IdTable.h"
+#include "Money.h"
 #include "Wallet.h"
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
-// Abstract base class representing a generic client
-class Client : public Entity {
+// Client tiers; each one has a row in TIER_POLICIES
+enum class ClientTier : std::uint8_t { STANDARD, GOLD, PLATINUM };
+
+// Commission and limit rules of a tier
+struct TierPolicy {
+    ClientTier tier;
+    const char* name;             // Name used by Clients.txt and the menu
+    std::int64_t commissionBps;   // Commission in basis points of the transferred amount
+    Money maxTransaction;         // Largest amount a single transfer may move
+};
+
+// Policy table, one row per tier in enum order. A new tier is an enumerator plus a row here.
+constexpr TierPolicy TIER_POLICIES[] = {
+    {ClientTier::STANDARD, "Standard", 500, money(1000)},   // 5%, $1000
+    {ClientTier::GOLD,     "Gold",     100, money(10000)},  // 1%, $10000
+    {ClientTier::PLATINUM, "Platinum", 200, money(5000)},   // 2%, $5000
+};
+
+constexpr std::size_t TIER_COUNT = sizeof(TIER_POLICIES) / sizeof(TIER_POLICIES[0]);
+
+// True if every row sits at the index of its tier, so tierPolicy() can index the table directly
+constexpr bool tierTableInOrder() {
+    for (std::size_t i = 0; i < TIER_COUNT; ++i) {
+        if (static_cast<std::size_t>(TIER_POLICIES[i].tier) != i)
+            return false;
+    }
+    return true;
+}
+static_assert(tierTableInOrder(), "TIER_POLICIES rows must follow the ClientTier order");
+
+// Policy of a tier (a table lookup, no dispatch)
+constexpr const TierPolicy& tierPolicy(ClientTier tier) {
+    return TIER_POLICIES[static_cast<std::size_t>(tier)];
+}
+
+// Name of a tier as written in Clients.txt
+inline const char* tierName(ClientTier tier) {
+    return tierPolicy(tier).name;
+}
+
+// Parses a tier name; false (tier unchanged) if no tier has that name
+bool tierFromName(std::string_view name, ClientTier& tier);
+
+// A client of the ledger. Its tier selects the commission rate and limit from TIER_POLICIES,
+// so the transaction path and the serializers branch on a small enum instead of calling virtuals.
+// Clients live in the ledger's client pool and own nothing: the ID and name are entries of the
+// ledger's interning tables and the wallets are chained through the wallets themselves, so the
+// class is trivially destructible and the pool releases clients slab by slab.
+class Client {
 protected:
-    std::string name;            // Client name
-    EntityVector wallets;        // Collection of wallets owned by the client
+    const std::string* id;       // Interned client ID
+    IdHandle handle;             // Handle of the ID in the ledger's client table
+    const std::string* name;     // Interned client name
+    ClientTier tier;             // Tier of the client
+    std::atomic<Money> totalBalance; // Sum of the wallet balances, kept current by the wallets
+    Wallet* firstWallet;         // Wallets of the client in the order they were added (non-owning)
+    Wallet* lastWallet;
+    std::size_t walletCount;
 public:
-    Client(const std::string& id, const std::string& name);
-    virtual ~Client();
+    // The ID and name must outlive the client (the ledger passes entries of its IdTables)
+    Client(const std::string& id, const std::string& name, ClientTier tier = ClientTier::STANDARD);
+
+    const std::string& getId() const { return *id; }
+    IdHandle getHandle() const { return handle; }
+    void setHandle(IdHandle value) { handle = value; }
+
+    void addWallet(Wallet* wallet);         // Lists a wallet under the client (does not take ownership)
+    bool removeWallet(const std::string& walletId); // Unlists a wallet; false if the client does not have it
+    Money getTotalBalance() const;          // Total balance of all wallets, O(1)
 
-    void addWallet(Wallet* wallet);         // Adds a wallet to the client
-    double getTotalBalance() const;         // Calculates the total balance from all wallets
+    // Applies a wallet balance change to the cached total; called by Wallet::deposit/withdraw.
+    // Atomic because the transfers of one parallel wave never share a wallet but may touch
+    // different wallets of the same client, so two workers can adjust one total at once.
+    void adjustTotalBalance(Money delta) { totalBalance.fetch_add(delta, std::memory_order_relaxed); }
 
-    virtual double calculateCommission(double amount) const = 0;   // Commission rate (pure virtual)
-    virtual double getMaxTransactionLimit() const = 0;             // Transaction limit (pure virtual)
+    // Commission on a transfer of the given amount, from the tier's rate
+    Money calculateCommission(Money amount) const { return applyRate(amount, tierPolicy(tier).commissionBps); }
+    // Largest amount the client may transfer at once
+    Money getMaxTransactionLimit() const { return tierPolicy(tier).maxTransaction; }
+    ClientTier getTier() const { return tier; }
 
-    std::string getId() const override;     // Returns client ID
-    std::string getName() const;            // Returns client name
-    const EntityVector& getWallets() const; // Returns reference to all client wallets
+    const std::string& getName() const;     // Returns client name
+    // First wallet of the client; Wallet::getNextOfOwner walks the rest in the order they were added
+    Wallet* getFirstWallet() const { return firstWallet; }
+    std::size_t getWalletCount() const { return walletCount; }
 };
 
 // Represents a standard client with the highest commission rate and lowest transaction limit
 class StandardClient : public Client {
 public:
     StandardClient(const std::string& id, const std::string& name);
-    double calculateCommission(double amount) const override;      // 5% commission
-    double getMaxTransactionLimit() const override;                // $1000 limit
 };
 
 // Represents a gold-level client with low commission and high transaction limit
 class GoldClient : public Client {
 public:
     GoldClient(const std::string& id, const std::string& name);
-    double calculateCommission(double amount) const override;      // 1% commission
-    double getMaxTransactionLimit() const override;                // $10000 limit
 };
 
 // Represents a platinum-level client with medium commission and limit
 class PlatinumClient : public Client {
 public:
     PlatinumClient(const std::string& id, const std::string& name);
-    double calculateCommission(double amount) const override;      // 2% commission
-    double getMaxTransactionLimit() const override;                // $5000 limit
 };
 
 #endif // CLIENT_H
@@ -1,133 +1,235 @@
 #include "ClientBST.h"
+#include <algorithm>
 
 // Constructor for a tree node that holds a Client pointer
 ClientNode::ClientNode(Client* client)
-    : data(client), left(nullptr), right(nullptr) {}
+    : data(client), left(nullptr), right(nullptr), balance(client->getTotalBalance()), height(1), count(1) {}
 
-// Destructor to delete the client data
-ClientNode::~ClientNode() {
-    delete data;
+static int heightOf(const ClientNode* node) {
+    return node ? node->height : 0;
 }
 
-// Constructor for the binary search tree
+static std::size_t countOf(const ClientNode* node) {
+    return node ? node->count : 0;
+}
+
+// Constructor for the client index
 ClientBST::ClientBST() : root(nullptr) {}
 
-// Destructor that destroys the entire tree recursively
-ClientBST::~ClientBST() {
-    destroyTree(root);
+// Destructor: nodes are trivially destructible, so the node pool only releases its slabs
+ClientBST::~ClientBST() {}
+
+// Recomputes the cached height and subtree size of a node
+void ClientBST::update(ClientNode* node) {
+    node->height = 1 + std::max(heightOf(node->left), heightOf(node->right));
+    node->count = 1 + countOf(node->left) + countOf(node->right);
 }
 
-// Recursively deletes nodes in the tree
-void ClientBST::destroyTree(ClientNode* node) {
-    if (!node) return;
-    destroyTree(node->left);
-    destroyTree(node->right);
-    delete node;
+// Orders nodes by balance, then by client handle so keys are unique
+bool ClientBST::keyLess(const ClientNode* a, const ClientNode* b) {
+    if (a->balance != b->balance)
+        return a->balance < b->balance;
+    return a->data->getHandle() < b->data->getHandle();
 }
 
-// Recursive insert based on client's total balance
-ClientNode* ClientBST::insert(ClientNode* node, Client* client) {
-    if (!node) return new ClientNode(client);
-    if (client->getTotalBalance() < node->data->getTotalBalance())
-        node->left = insert(node->left, client);
-    else
-        node->right = insert(node->right, client);
+ClientNode* ClientBST::rotateLeft(ClientNode* node) {
+    ClientNode* pivot = node->right;
+    node->right = pivot->left;
+    pivot->left = node;
+    update(node);
+    update(pivot);
+    return pivot;
+}
+
+ClientNode* ClientBST::rotateRight(ClientNode* node) {
+    ClientNode* pivot = node->left;
+    node->left = pivot->right;
+    pivot->right = node;
+    update(node);
+    update(pivot);
+    return pivot;
+}
+
+// Restores the AVL property after an insertion or removal below this node
+ClientNode* ClientBST::rebalance(ClientNode* node) {
+    update(node);
+    int diff = heightOf(node->left) - heightOf(node->right);
+    if (diff > 1) {
+        if (heightOf(node->left->left) < heightOf(node->left->right))
+            node->left = rotateLeft(node->left);
+        return rotateRight(node);
+    }
+    if (diff < -1) {
+        if (heightOf(node->right->right) < heightOf(node->right->left))
+            node->right = rotateRight(node->right);
+        return rotateLeft(node);
+    }
     return node;
 }
 
+// Recursive insert based on (total balance, client ID)
+ClientNode* ClientBST::insert(ClientNode* node, ClientNode* newNode) {
+    if (!node) return newNode;
+    if (keyLess(newNode, node))
+        node->left = insert(node->left, newNode);
+    else
+        node->right = insert(node->right, newNode);
+    return rebalance(node);
+}
+
 // Public insert method
-void ClientBST::insert(Client* client) {
-    root = insert(root, client);
+bool ClientBST::insert(Client* client) {
+    IdHandle handle = client->getHandle();
+    if (handle == NO_HANDLE)
+        return false;
+    if (handle >= byHandle.size())
+        byHandle.resize(handle + 1, nullptr);
+    if (byHandle[handle])
+        return false;
+    ClientNode* node = nodes.create(client);
+    byHandle[handle] = node;
+    root = insert(root, node);
+    return true;
 }
 
-// Finds the node with the smallest balance (leftmost node)
+// Finds the node with the smallest key (leftmost node)
 ClientNode* ClientBST::findMin(ClientNode* node) {
     while (node && node->left) node = node->left;
     return node;
 }
 
-// Removes the minimum node in the subtree
+// Unlinks the minimum node in the subtree
 ClientNode* ClientBST::removeMin(ClientNode* node) {
     if (!node->left) return node->right;
     node->left = removeMin(node->left);
-    return node;
+    return rebalance(node);
 }
 
-// Recursively removes a client by ID
-ClientNode* ClientBST::remove(ClientNode* node, const std::string& id, bool& success) {
-    if (!node) {
-        success = false;
-        return nullptr;
-    }
+// Recursively unlinks the target node; the node itself is left intact
+ClientNode* ClientBST::detach(ClientNode* node, ClientNode* target) {
+    if (!node) return nullptr;
 
-    if (id == node->data->getId()) {
-        success = true;
+    if (node == target) {
+        ClientNode* leftChild = node->left;
+        ClientNode* rightChild = node->right;
+        node->left = node->right = nullptr;
+        node->height = 1;
+        node->count = 1;
+
+        if (!leftChild) return rightChild;
+        if (!rightChild) return leftChild;
+
+        // Two children – the smallest node of the right subtree takes the place of the target
+        ClientNode* minNode = findMin(rightChild);
+        minNode->right = removeMin(rightChild);
+        minNode->left = leftChild;
+        return rebalance(minNode);
+    }
 
-        // Case: no left child
-        if (!node->left) {
-            ClientNode* rightChild = node->right;
-            node->right = nullptr;
-            delete node;
-            return rightChild;
-        }
-        // Case: no right child
-        else if (!node->right) {
-            ClientNode* leftChild = node->left;
-            node->left = nullptr;
-            delete node;
-            return leftChild;
-        }
+    if (keyLess(target, node))
+        node->left = detach(node->left, target);
+    else
+        node->right = detach(node->right, target);
+    return rebalance(node);
+}
 
-        // Case: two children – find the smallest in the right subtree
-        ClientNode* minNode = findMin(node->right);
-        Client* tempData = node->data;
-        node->data = minNode->data;
-        minNode->data = tempData;
+// Public method to remove a client by handle
+bool ClientBST::remove(IdHandle handle) {
+    ClientNode* node = handle < byHandle.size() ? byHandle[handle] : nullptr;
+    if (!node)
+        return false;
+    byHandle[handle] = nullptr;
+    root = detach(root, node);
+    nodes.destroy(node);
+    return true;
+}
 
-        node->right = remove(node->right, minNode->data->getId(), success);
-        return node;
-    }
-    else if (id < node->data->getId())
-        node->left = remove(node->left, id, success);
-    else
-        node->right = remove(node->right, id, success);
+// Looks a client up through the handle index
+Client* ClientBST::find(IdHandle handle) const {
+    ClientNode* node = handle < byHandle.size() ? byHandle[handle] : nullptr;
+    return node ? node->data : nullptr;
+}
 
-    return node;
+// Moves a client to its new position when its total balance no longer matches its key
+void ClientBST::updateBalance(Client* client) {
+    IdHandle handle = client->getHandle();
+    ClientNode* node = handle < byHandle.size() ? byHandle[handle] : nullptr;
+    if (!node || node->data != client)
+        return;
+    Money balance = client->getTotalBalance();
+    if (balance == node->balance)
+        return;
+    root = detach(root, node);
+    node->balance = balance;
+    root = insert(root, node);
 }
 
-// Public method to remove a client by ID
-bool ClientBST::remove(const std::string& id) {
-    bool success = false;
-    root = remove(root, id, success);
-    return success;
+// Returns the number of clients in the index
+std::size_t ClientBST::size() const {
+    return countOf(root);
 }
 
-// Recursively searches for a client node by ID
-ClientNode* ClientBST::find(ClientNode* node, const std::string& id) const {
-    if (!node) return nullptr;
-    if (id == node->data->getId()) return node;
-    if (id < node->data->getId()) return find(node->left, id);
-    return find(node->right, id);
+// Counts the nodes ordered before the client, then converts it to a descending rank
+std::size_t ClientBST::rankOf(IdHandle handle) const {
+    const ClientNode* target = handle < byHandle.size() ? byHandle[handle] : nullptr;
+    if (!target)
+        return 0;
+
+    std::size_t smaller = 0;
+    const ClientNode* current = root;
+    while (current && current != target) {
+        if (keyLess(target, current)) {
+            current = current->left;
+        } else {
+            smaller += countOf(current->left) + 1;
+            current = current->right;
+        }
+    }
+    if (current)
+        smaller += countOf(current->left);
+    return size() - smaller;
 }
 
-// Public method to find a client by ID
-Client* ClientBST::find(const std::string& id) const {
-    ClientNode* node = find(root, id);
-    return node ? node->data : nullptr;
+// Reverse in-order traversal (right → root → left) stopping after n clients
+std::vector<Client*> ClientBST::topN(std::size_t n) const {
+    std::vector<Client*> result;
+    std::vector<ClientNode*> stack;
+    ClientNode* current = root;
+    while ((current || !stack.empty()) && result.size() < n) {
+        while (current) {
+            stack.push_back(current);
+            current = current->right;
+        }
+        current = stack.back();
+        stack.pop_back();
+        result.push_back(current->data);
+        current = current->left;
+    }
+    return result;
 }
 
-// Recursively displays the tree in-order (left → root → right)
-void ClientBST::displayInOrder(ClientNode* node) const {
-    if (!node) return;
-    displayInOrder(node->left);
-    std::cout << "Client ID: " << node->data->getId()
-              << ", Total Balance: " << node->data->getTotalBalance() << std::endl;
-    displayInOrder(node->right);
+// Iterative in-order traversal (left → root → right)
+void ClientBST::forEachInOrder(const std::function<void(Client*)>& visit) const {
+    std::vector<ClientNode*> stack;
+    ClientNode* current = root;
+    while (current || !stack.empty()) {
+        while (current) {
+            stack.push_back(current);
+            current = current->left;
+        }
+        current = stack.back();
+        stack.pop_back();
+        visit(current->data);
+        current = current->right;
+    }
 }
 
-// Public method to trigger in-order display
+// Displays all clients in ascending order of total balance
 void ClientBST::displayInOrder() const {
-    displayInOrder(root);
+    forEachInOrder([](Client* client) {
+        std::cout << "Client ID: " << client->getId()
+                  << ", Total Balance: " << formatMoney(client->getTotalBalance()) << std::endl;
+    });
 }
 
 // Returns the root of the tree
@@ -2,41 +2,63 @@
 #define CLIENTBST_H
 
 #include "Client.h"
+#include "ObjectPool.h"
+#include <cstddef>
+#include <functional>
 #include <iostream>
+#include <string>
+#include <vector>
 
-// Node class representing each node in the Binary Search Tree (BST) of clients
+// Node class representing each node in the balanced Binary Search Tree (AVL) of clients
 class ClientNode {
 public:
     Client* data;            // Pointer to the client stored in this node
     ClientNode* left;        // Pointer to the left child
     ClientNode* right;       // Pointer to the right child
+    Money balance;           // Total balance the node is currently ordered by
+    int height;              // Height of the subtree rooted at this node
+    std::size_t count;       // Number of nodes in the subtree (used for rank queries)
 
-    ClientNode(Client* client); // Constructor
-    ~ClientNode();              // Destructor
+    ClientNode(Client* client); // Constructor (the node does not own the client)
 };
 
-// Class representing the Binary Search Tree structure for managing clients
+// Dual-key client index: an AVL tree ordered by (total balance, client handle)
+// plus an array from client handle to its tree node.
+// Clients must carry their interned handle (Client::getHandle) before they are inserted.
+// The index does not own its clients (they live in the ledger's client pool).
+// Lookup by handle is O(1), insert/remove/reposition and rank queries are O(log n).
 class ClientBST {
 private:
-    ClientNode* root;  // Root node of the BST
+    ClientNode* root;                                    // Root node of the AVL tree
+    ObjectPool<ClientNode> nodes;                        // Storage of the tree nodes
+    std::vector<ClientNode*> byHandle;   // Client handle -> node (nullptr if absent)
 
-    // Helper methods for recursive operations
-    ClientNode* insert(ClientNode* node, Client* client);                // Inserts a client into the tree
-    ClientNode* remove(ClientNode* node, const std::string& id, bool& success); // Removes a client by ID
-    ClientNode* findMin(ClientNode* node);                               // Finds node with minimum value (leftmost)
-    ClientNode* removeMin(ClientNode* node);                             // Removes the node with minimum value
-    ClientNode* find(ClientNode* node, const std::string& id) const;     // Finds a node by client ID
-    void displayInOrder(ClientNode* node) const;                         // In-order traversal display
-    void destroyTree(ClientNode* node);                                  // Recursively deletes the tree
+    // Helper methods for recursive operations (depth is bounded by the AVL height)
+    ClientNode* insert(ClientNode* node, ClientNode* newNode);   // Inserts a node into the tree
+    ClientNode* detach(ClientNode* node, ClientNode* target);    // Unlinks a node without deleting it
+    ClientNode* findMin(ClientNode* node);                       // Finds node with minimum key (leftmost)
+    ClientNode* removeMin(ClientNode* node);                     // Unlinks the node with minimum key
+    ClientNode* rebalance(ClientNode* node);                     // Restores the AVL property at a node
+    ClientNode* rotateLeft(ClientNode* node);
+    ClientNode* rotateRight(ClientNode* node);
+    static void update(ClientNode* node);                        // Recomputes height and subtree size
+    static bool keyLess(const ClientNode* a, const ClientNode* b); // Orders by (balance, handle)
 
 public:
     ClientBST();   // Constructor
     ~ClientBST();  // Destructor
 
-    void insert(Client* client);               // Public method to insert a client
-    bool remove(const std::string& id);        // Public method to remove a client by ID
-    Client* find(const std::string& id) const; // Public method to find a client by ID
-    void displayInOrder() const;               // Public method to display all clients in-order
+    bool insert(Client* client);               // Inserts a client; false if the handle already exists
+    bool remove(IdHandle handle);              // Removes a client by handle (the client itself is left alone)
+    Client* find(IdHandle handle) const;       // Finds a client by handle
+    void updateBalance(Client* client);        // Repositions a client after its total balance changed
+
+    std::size_t size() const;                          // Number of clients in the index
+    std::size_t rankOf(IdHandle handle) const;         // 1-based rank by descending balance, 0 if absent
+    std::vector<Client*> topN(std::size_t n) const;    // The n clients with the highest balances
+
+    void forEachInOrder(const std::function<void(Client*)>& visit) const; // Ascending balance order
+    void displayInOrder() const;               // Displays all clients in ascending balance order
 
     ClientNode* getRoot() const;               // Getter for the root node
 };
@@ -1,19 +1,32 @@
 #ifndef ENTITY_H
 #define ENTITY_H
 
+#include "IdTable.h"
 #include <string>
+#include <utility>
 
-// Abstract base class representing a general entity with a unique identifier.
-// Used as a base for derived classes such as Client, Wallet, and Transaction.
+// Base class representing a general entity with a unique identifier.
+// Used as the base of Transaction (clients and wallets keep interned IDs instead, see Client).
 class Entity {
 protected:
-    std::string id;  // Unique identifier for the entity
+    std::string id;     // Unique identifier for the entity
+    IdHandle handle;    // Interned form of the ID, assigned by the ledger (NO_HANDLE until then)
 public:
-    // Constructor that initializes the entity's ID
-    Entity(const std::string& id) : id(id) {}
+    // Constructor that initializes the entity's ID (moved in, so callers can pass temporaries without a copy)
+    Entity(std::string id) : id(std::move(id)), handle(NO_HANDLE) {}
 
-    // Pure virtual method that must be implemented by all derived classes to return the entity ID
-    virtual std::string getId() const = 0;
+    // Returns the entity ID (by reference, so comparisons and lookups do not copy it)
+    const std::string& getId() const { return id; }
+
+    // Handle of the ID in the ledger's interning table
+    IdHandle getHandle() const { return handle; }
+    void setHandle(IdHandle value) { handle = value; }
+
+    // Entities are copyable and movable (transactions are moved into the transaction store)
+    Entity(const Entity&) = default;
+    Entity(Entity&&) = default;
+    Entity& operator=(const Entity&) = default;
+    Entity& operator=(Entity&&) = default;
 
     // Virtual destructor to allow proper cleanup in derived classes
     virtual ~Entity() {}
@@ -0,0 +1,176 @@
+#include "GroupCommitLog.h"
+#include <iostream>
+#include <utility>
+
+// Constructor creates a closed log
+GroupCommitLog::GroupCommitLog()
+    : queuedCount(0), submitted(0), processed(0), durable(0), failed(false), stopping(false),
+      stats{0, 0, 0}, callbackRunning(false) {}
+
+// Destructor syncs the queued records and stops the writer
+GroupCommitLog::~GroupCommitLog() {
+    close();
+}
+
+bool GroupCommitLog::open(const std::string& filename, const GroupCommitConfig& groupConfig) {
+    close();
+    if (!log.open(filename))
+        return false;
+    config = groupConfig;
+    if (config.batchSize == 0) config.batchSize = 1;
+    stopping = false;
+    writer = std::thread(&GroupCommitLog::writerLoop, this);
+    return true;
+}
+
+// Lets the writer drain the queue, then joins it
+void GroupCommitLog::close() {
+    if (!writer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+    log.close();
+}
+
+bool GroupCommitLog::reopen(const std::string& filename) {
+    GroupCommitConfig current = config;
+    close();
+    return open(filename, current);
+}
+
+bool GroupCommitLog::isOpen() const {
+    return writer.joinable();
+}
+
+// Writer thread: takes the queued records as one group, writes and syncs them, marks them durable
+void GroupCommitLog::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    std::string group;
+    while (true) {
+        wake.wait(lock, [this] { return stopping || queuedCount > 0; });
+        if (queuedCount == 0)
+            return;  // Stopping with nothing left
+
+        // Let the group fill up until it is big enough or its oldest record has waited long enough
+        auto deadline = firstQueued + std::chrono::milliseconds(config.flushIntervalMs);
+        wake.wait_until(lock, deadline, [this] { return stopping || queuedCount >= config.batchSize; });
+
+        group.clear();
+        group.swap(queued);
+        std::size_t count = queuedCount;
+        std::uint64_t upTo = submitted;
+        queuedCount = 0;
+        bool skip = failed;
+        lock.unlock();
+
+        bool ok = !skip && log.appendLines(group) && log.sync();
+        if (!ok && !skip)
+            std::cerr << "Write-ahead log: write or sync failed, commits are no longer durable\n";
+
+        lock.lock();
+        processed = upTo;
+        if (ok) {
+            durable = upTo;
+            stats.records += count;
+            stats.groups++;
+        } else {
+            failed = true;
+            stats.failures++;
+        }
+        std::function<void(std::uint64_t)> callback = onDurable;
+        durableChanged.notify_all();
+        if (callback) {
+            callbackRunning = true;
+            lock.unlock();
+            callback(upTo);
+            lock.lock();
+            callbackRunning = false;
+            durableChanged.notify_all();
+        }
+    }
+}
+
+// Queues formatted lines and wakes the writer when a group starts or fills up
+std::uint64_t GroupCommitLog::enqueue(const std::string& lines, std::size_t count) {
+    if (!isOpen()) return 0;
+    bool notify;
+    std::uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queuedCount == 0)
+            firstQueued = std::chrono::steady_clock::now();
+        bool wasBelow = queuedCount < config.batchSize;
+        queued += lines;
+        queuedCount += count;
+        submitted += count;
+        ticket = submitted;
+        notify = queuedCount == count || (wasBelow && queuedCount >= config.batchSize);
+    }
+    if (notify)
+        wake.notify_one();
+    return ticket;
+}
+
+std::uint64_t GroupCommitLog::append(const Transaction& tx) {
+    std::string line = formatTransactionRecord(tx);
+    line += '\n';
+    return enqueue(line, 1);
+}
+
+std::uint64_t GroupCommitLog::append(Transaction* const* txs, std::size_t count) {
+    if (count == 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return submitted;
+    }
+    std::string lines;
+    lines.reserve(count * 64);
+    for (std::size_t i = 0; i < count; ++i) {
+        lines += formatTransactionRecord(*txs[i]);
+        lines += '\n';
+    }
+    return enqueue(lines, count);
+}
+
+bool GroupCommitLog::waitDurable(std::uint64_t ticket) {
+    std::unique_lock<std::mutex> lock(mutex);
+    durableChanged.wait(lock, [&] { return processed >= ticket; });
+    return durable >= ticket;
+}
+
+std::uint64_t GroupCommitLog::getDurable() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return durable;
+}
+
+std::uint64_t GroupCommitLog::getProcessed() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return processed;
+}
+
+bool GroupCommitLog::hasFailed() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return failed;
+}
+
+void GroupCommitLog::setDurableCallback(std::function<void(std::uint64_t)> callback) {
+    std::unique_lock<std::mutex> lock(mutex);
+    durableChanged.wait(lock, [this] { return !callbackRunning; });
+    onDurable = std::move(callback);
+}
+
+// Waits until the writer is idle with an empty queue; the log is then only touched under the lock
+bool GroupCommitLog::reset() {
+    if (!isOpen()) return false;
+    std::unique_lock<std::mutex> lock(mutex);
+    wake.notify_one();
+    durableChanged.wait(lock, [this] { return processed == submitted; });
+    return log.reset();
+}
+
+GroupCommitStats GroupCommitLog::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
@@ -0,0 +1,94 @@
+#ifndef GROUPCOMMITLOG_H
+#define GROUPCOMMITLOG_H
+
+#include "Transaction.h"
+#include "TransactionLog.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// When the writer thread syncs a group
+struct GroupCommitConfig {
+    std::size_t batchSize = 4096;     // Records that start a sync without waiting for the interval
+    std::uint32_t flushIntervalMs = 2; // Longest wait of the first record of a group (0 = sync at once)
+};
+
+// Counters of a group-commit log
+struct GroupCommitStats {
+    std::uint64_t records;   // Records made durable
+    std::uint64_t groups;    // Write + fsync rounds
+    std::uint64_t failures;  // Rounds whose write or fsync failed, or dropped after a failure
+};
+
+// Write-ahead log with group commit on a background writer thread.
+// append() formats the records on the caller's thread, queues them and returns a ticket at once.
+// The writer takes everything queued, writes it in one go and fsyncs once per group, then marks
+// the group durable: waitDurable() callers wake up and the durable callback runs. A group is
+// synced when it holds batchSize records or its first record has waited flushIntervalMs, so a
+// longer interval trades latency for fewer syncs. Records use the TransactionLog line format and
+// keep their append order. append, waitDurable and getDurable may be called from any thread.
+// A failed write or sync stops durability for good (the file state is unknown past it): later
+// groups are dropped and reported as failed, and the owner is expected to stop taking commits.
+class GroupCommitLog {
+private:
+    TransactionLog log;                        // Written by the writer thread only
+    GroupCommitConfig config;
+    std::thread writer;
+    mutable std::mutex mutex;                  // Guards the fields below
+    std::condition_variable wake;              // Signals the writer: records queued or shutdown
+    std::condition_variable durableChanged;    // Signals waitDurable callers
+    std::string queued;                        // Formatted records not taken by the writer yet
+    std::size_t queuedCount;                   // Records in queued
+    std::chrono::steady_clock::time_point firstQueued;  // When the oldest queued record arrived
+    std::uint64_t submitted;                   // Tickets handed out (records appended)
+    std::uint64_t processed;                   // Records the writer is done with, synced or not
+    std::uint64_t durable;                     // Records written and synced
+    bool failed;                               // A write or sync failed: nothing after it is durable
+    bool stopping;
+    GroupCommitStats stats;
+    std::function<void(std::uint64_t)> onDurable;
+    bool callbackRunning;                      // onDurable is running on the writer thread
+
+    void writerLoop();
+    std::uint64_t enqueue(const std::string& lines, std::size_t count);
+
+public:
+    GroupCommitLog();
+    ~GroupCommitLog();                         // Syncs what is queued and stops the writer
+
+    GroupCommitLog(const GroupCommitLog&) = delete;
+    GroupCommitLog& operator=(const GroupCommitLog&) = delete;
+
+    // Opens (or creates) the log like TransactionLog::open and starts the writer thread
+    bool open(const std::string& filename, const GroupCommitConfig& config);
+    void close();                              // Syncs what is queued, stops the writer, closes the file
+    bool reopen(const std::string& filename);  // Syncs what is queued and continues in another file; tickets go on
+    bool isOpen() const;
+
+    // Queue committed transactions; return the ticket of the last one (the latest ticket for an
+    // empty range, 0 if the log is closed). open and close belong to the owner's thread.
+    // Tickets count records from 1, so a record is durable once getDurable() reaches its ticket.
+    std::uint64_t append(const Transaction& tx);
+    std::uint64_t append(Transaction* const* txs, std::size_t count);
+
+    // Blocks until the writer is done with the record with this ticket; false if it is not durable
+    bool waitDurable(std::uint64_t ticket);
+    std::uint64_t getDurable() const;          // Ticket up to which every record is synced
+    std::uint64_t getProcessed() const;        // Ticket up to which the writer is done (>= getDurable())
+    bool hasFailed() const;
+
+    // Called on the writer thread after each group with getProcessed() (not under the lock).
+    // Pass an empty function to remove it; once this returns, the old callback is not running.
+    // Must not be called from the callback itself.
+    void setDurableCallback(std::function<void(std::uint64_t)> callback);
+
+    bool reset();                              // Syncs what is queued, then empties the log
+    GroupCommitStats getStats() const;
+};
+
+#endif // GROUPCOMMITLOG_H
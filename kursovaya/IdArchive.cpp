@@ -0,0 +1,253 @@
+#include "IdArchive.h"
+#include "BloomFilter.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <utility>
+
+static const std::uint32_t RUN_MAGIC = 0x5244494B;   // "KIDR"
+static const std::uint32_t RUN_VERSION = 1;
+static const std::size_t HEADER_SIZE = 64;            // Keeps the filter blocks cache-line aligned
+static const std::size_t BLOCK_BYTES = BloomFilter::BLOCK_WORDS * sizeof(std::uint64_t);
+
+// The filters are stored, so the hash must not change between builds (std::hash may):
+// FNV-1a, with a finalizer so every bit depends on the whole ID
+static std::uint64_t idHash(std::string_view id) {
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (char c : id) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static std::uint64_t readU64(const char* at) {
+    std::uint64_t value;
+    std::memcpy(&value, at, sizeof(value));
+    return value;
+}
+
+static std::string paddedNumber(std::uint64_t n) {
+    std::string digits = std::to_string(n);
+    return digits.size() < 6 ? std::string(6 - digits.size(), '0') + digits : digits;
+}
+
+std::string_view IdArchive::Run::id(std::uint64_t i) const {
+    std::uint64_t begin = offsets[i];
+    std::uint64_t finish = offsets[i + 1];
+    if (begin > finish || finish > stringBytes)
+        return std::string_view();  // Damaged offsets read as an empty ID instead of out of bounds
+    return std::string_view(strings + begin, static_cast<std::size_t>(finish - begin));
+}
+
+bool IdArchive::Run::contains(std::string_view wanted, std::uint64_t hash) const {
+    if (!BloomFilter::mayContain(filter, static_cast<std::size_t>(filterBlocks), hash))
+        return false;
+    std::uint64_t low = 0, high = count;
+    while (low < high) {
+        std::uint64_t middle = low + (high - low) / 2;
+        if (id(middle) < wanted)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low < count && id(low) == wanted;
+}
+
+IdArchive::IdArchive(std::string prefix) : prefix(std::move(prefix)) {}
+
+std::string IdArchive::runFile(std::uint64_t first, std::uint64_t end) const {
+    return prefix + "ids_" + paddedNumber(first) + "_" + paddedNumber(end) + ".run";
+}
+
+bool IdArchive::mapRun(std::uint64_t first, std::uint64_t end, Run& run) const {
+    run.file.reset(new MappedFile());
+    if (!run.file->open(runFile(first, end)) || run.file->getSize() < HEADER_SIZE)
+        return false;
+    const char* data = run.file->getData();
+    const std::uint64_t size = run.file->getSize();
+    std::uint32_t magic, version;
+    std::memcpy(&magic, data, sizeof(magic));
+    std::memcpy(&version, data + 4, sizeof(version));
+    run.first = readU64(data + 8);
+    run.end = readU64(data + 16);
+    run.count = readU64(data + 24);
+    run.filterBlocks = readU64(data + 32);
+    run.stringBytes = readU64(data + 40);
+    if (magic != RUN_MAGIC || version != RUN_VERSION || run.first != first || run.end != end)
+        return false;
+
+    // Every part must fit the file exactly; each bound is checked before it is used in the next
+    std::uint64_t left = size - HEADER_SIZE;
+    if (run.filterBlocks > left / BLOCK_BYTES) return false;
+    left -= run.filterBlocks * BLOCK_BYTES;
+    if (run.count >= left / sizeof(std::uint64_t)) return false;
+    left -= (run.count + 1) * sizeof(std::uint64_t);
+    if (run.stringBytes != left) return false;
+
+    // The mapping is page-aligned and every part starts on an 8-byte boundary
+    run.filter = reinterpret_cast<const std::uint64_t*>(data + HEADER_SIZE);
+    run.offsets = run.filter + run.filterBlocks * BloomFilter::BLOCK_WORDS;
+    run.strings = reinterpret_cast<const char*>(run.offsets + run.count + 1);
+    return run.offsets[0] == 0 && run.offsets[run.count] == run.stringBytes;
+}
+
+bool IdArchive::writeRun(std::uint64_t first, std::uint64_t end, const std::vector<std::string_view>& ids,
+                         Run& run) {
+    BloomFilter filter;
+    filter.reset(ids.size());
+    std::uint64_t stringBytes = 0;
+    for (std::string_view id : ids) {
+        filter.add(idHash(id));
+        stringBytes += id.size();
+    }
+
+    ByteBuffer contents;
+    contents.putU32(RUN_MAGIC);
+    contents.putU32(RUN_VERSION);
+    contents.putU64(first);
+    contents.putU64(end);
+    contents.putU64(ids.size());
+    contents.putU64(filter.getBlockCount());
+    contents.putU64(stringBytes);
+    while (contents.getSize() < HEADER_SIZE)
+        contents.putU8(0);
+    contents.putBytes(reinterpret_cast<const char*>(filter.getWords()), filter.getBlockCount() * BLOCK_BYTES);
+    std::uint64_t offset = 0;
+    contents.putU64(offset);
+    for (std::string_view id : ids)
+        contents.putU64(offset += id.size());
+    for (std::string_view id : ids)
+        contents.putBytes(id.data(), id.size());
+
+    if (!replaceFile(runFile(first, end), contents)) {
+        std::cerr << runFile(first, end) << ": cannot write the ID archive\n";
+        return false;
+    }
+    return mapRun(first, end, run);
+}
+
+bool IdArchive::mergeNewest() {
+    const Run& older = runs[runs.size() - 2];
+    const Run& newer = runs.back();
+    // Runs cover disjoint segments, so their IDs are distinct and a merge keeps them sorted
+    std::vector<std::string_view> ids;
+    ids.reserve(static_cast<std::size_t>(older.count + newer.count));
+    for (std::uint64_t i = 0; i < older.count; ++i) ids.push_back(older.id(i));
+    std::size_t middle = ids.size();
+    for (std::uint64_t i = 0; i < newer.count; ++i) ids.push_back(newer.id(i));
+    std::inplace_merge(ids.begin(), ids.begin() + static_cast<std::ptrdiff_t>(middle), ids.end());
+
+    Run merged;
+    if (!writeRun(older.first, newer.end, ids, merged))
+        return false;
+    std::error_code ec;
+    for (std::size_t i = runs.size() - 2; i < runs.size(); ++i) {
+        runs[i].file->close();
+        std::filesystem::remove(runFile(runs[i].first, runs[i].end), ec);
+    }
+    runs.pop_back();
+    runs.back() = std::move(merged);
+    return true;
+}
+
+bool IdArchive::open() {
+    runs.clear();
+    std::filesystem::path pattern(prefix + "ids_");
+    std::filesystem::path directory = pattern.parent_path();
+    const std::string start = pattern.filename().string();
+
+    // Run names, and leftovers of runs interrupted before their rename
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator entry(directory.empty() ? "." : directory, ec), last;
+         !ec && entry != last; entry.increment(ec)) {
+        std::string name = entry->path().filename().string();
+        if (name.compare(0, start.size(), start) != 0)
+            continue;
+        if (name.size() > 8 && name.compare(name.size() - 8, 8, ".run.tmp") == 0) {
+            std::error_code ignored;
+            std::filesystem::remove(entry->path(), ignored);
+            continue;
+        }
+        const char* digits = name.c_str() + start.size();
+        char* after;
+        std::uint64_t first = std::strtoull(digits, &after, 10);
+        if (after == digits || *after != '_') continue;
+        digits = after + 1;
+        std::uint64_t end = std::strtoull(digits, &after, 10);
+        if (after != digits && std::string(after) == ".run" && first < end)
+            ranges.emplace_back(first, end);
+    }
+    // Widest first among runs starting together, so a run a merge replaced follows its merge
+    std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first < b.first : a.second > b.second;
+    });
+
+    bool ok = true;
+    std::uint64_t covered = 0;
+    for (const auto& range : ranges) {
+        if (range.second <= covered) {
+            std::filesystem::remove(runFile(range.first, range.second), ec);
+            continue;
+        }
+        Run run;
+        if (!mapRun(range.first, range.second, run)) {
+            std::cerr << runFile(range.first, range.second) << ": unreadable ID archive run, skipped\n";
+            ok = false;
+            continue;
+        }
+        covered = range.second;
+        runs.push_back(std::move(run));
+    }
+    return ok;
+}
+
+bool IdArchive::addRun(std::uint64_t first, std::uint64_t end, std::vector<std::string> ids) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    std::vector<std::string_view> views(ids.begin(), ids.end());
+
+    Run run;
+    if (!writeRun(first, end, views, run))
+        return false;
+    runs.push_back(std::move(run));
+    while (runs.size() >= 2 && runs[runs.size() - 2].count <= 2 * runs.back().count) {
+        if (!mergeNewest())
+            return false;
+    }
+    return true;
+}
+
+bool IdArchive::contains(std::string_view id) const {
+    if (runs.empty())
+        return false;
+    std::uint64_t hash = idHash(id);
+    for (auto run = runs.rbegin(); run != runs.rend(); ++run) {
+        if (run->contains(id, hash))
+            return true;
+    }
+    return false;
+}
+
+std::uint64_t IdArchive::getEnd() const {
+    return runs.empty() ? 0 : runs.back().end;
+}
+
+std::size_t IdArchive::getRunCount() const {
+    return runs.size();
+}
+
+std::uint64_t IdArchive::getIdCount() const {
+    std::uint64_t total = 0;
+    for (const Run& run : runs)
+        total += run.count;
+    return total;
+}
@@ -0,0 +1,71 @@
+#ifndef IDARCHIVE_H
+#define IDARCHIVE_H
+
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Transaction IDs of the log segments that checkpoints compacted away, kept on disk so they are
+// still rejected as duplicates after a restart (see CheckpointManager).
+// The IDs of segments [first, end) are stored in a run file, P + "ids_<first>_<end>.run":
+//   header  : magic "KIDR" (u32), version (u32), first (u64), end (u64), ID count (u64),
+//             filter blocks (u64), string bytes (u64), zeros up to 64 bytes
+//   filter  : Bloom filter of the IDs (see BloomFilter), 64 bytes per block
+//   offsets : count + 1 u64 offsets of the IDs in the string bytes
+//   strings : the distinct IDs in ascending order, concatenated
+// Runs are memory-mapped, not read, so opening the archive costs one header check per run
+// whatever the history holds, and contains() tests each run's filter (one cache line) before it
+// binary-searches the run. addRun() writes a run under a temporary name, syncs and renames it,
+// then merges the two newest runs for as long as the older is at most twice the size of the
+// newer: there are O(log n) runs and each ID is rewritten O(log n) times. The files a merge
+// replaced are deleted, or by the next open() if that failed (a mapped file on Windows).
+// Not thread-safe.
+class IdArchive {
+private:
+    struct Run {
+        std::uint64_t first;           // First segment covered
+        std::uint64_t end;             // First segment after the run
+        std::uint64_t count;           // IDs in the run
+        std::uint64_t filterBlocks;
+        const std::uint64_t* filter;   // Views into the mapping
+        const std::uint64_t* offsets;
+        const char* strings;
+        std::uint64_t stringBytes;
+        std::unique_ptr<MappedFile> file;
+
+        std::string_view id(std::uint64_t i) const;  // i-th ID in sorted order
+        bool contains(std::string_view id, std::uint64_t hash) const;
+    };
+
+    std::string prefix;       // Path prefix of the run files
+    std::vector<Run> runs;    // Ordered by the segments they cover
+
+    std::string runFile(std::uint64_t first, std::uint64_t end) const;
+    bool mapRun(std::uint64_t first, std::uint64_t end, Run& run) const;  // False if unreadable
+    // Writes and maps the run of sorted, distinct ids covering [first, end)
+    bool writeRun(std::uint64_t first, std::uint64_t end, const std::vector<std::string_view>& ids, Run& run);
+    bool mergeNewest();       // Replaces the two newest runs with one
+
+public:
+    explicit IdArchive(std::string prefix);
+
+    IdArchive(const IdArchive&) = delete;
+    IdArchive& operator=(const IdArchive&) = delete;
+
+    // Maps the run files under the prefix, dropping leftovers of interrupted writes and merges;
+    // false if a run cannot be read (it is skipped)
+    bool open();
+    // Archives the IDs of segments [first, end), in any order and with repeats
+    bool addRun(std::uint64_t first, std::uint64_t end, std::vector<std::string> ids);
+
+    bool contains(std::string_view id) const;   // True if an archived segment committed the ID
+    std::uint64_t getEnd() const;               // First segment not archived, 0 if none is
+    std::size_t getRunCount() const;
+    std::uint64_t getIdCount() const;
+};
+
+#endif // IDARCHIVE_H
@@ -0,0 +1,33 @@
+#include "IdTable.h"
+
+// Returns the existing handle, or stores the ID and hands out the next one
+IdHandle IdTable::intern(std::string_view id) {
+    auto it = handles.find(id);
+    if (it != handles.end())
+        return it->second;
+    IdHandle handle = static_cast<IdHandle>(names.size());
+    names.emplace_back(id);
+    handles.emplace(names.back(), handle);
+    return handle;
+}
+
+// Looks an ID up without interning it
+IdHandle IdTable::find(std::string_view id) const {
+    auto it = handles.find(id);
+    return it != handles.end() ? it->second : NO_HANDLE;
+}
+
+// Returns the ID behind a handle
+const std::string& IdTable::name(IdHandle handle) const {
+    return names[handle];
+}
+
+// Returns the number of interned IDs
+std::size_t IdTable::size() const {
+    return names.size();
+}
+
+// Pre-sizes the hash index so bulk loads do not rehash
+void IdTable::reserve(std::size_t count) {
+    handles.reserve(count);
+}
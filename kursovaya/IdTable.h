@@ -0,0 +1,34 @@
+#ifndef IDTABLE_H
+#define IDTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Dense integer handle standing for an interned string ID
+typedef std::uint32_t IdHandle;
+
+// Handle of an ID that was never interned
+const IdHandle NO_HANDLE = 0xFFFFFFFFu;
+
+// Interning table mapping external string IDs to dense handles 0, 1, 2, ...
+// IDs are translated once at the ledger boundary (loading, addClient, transaction intake),
+// so the indexes behind it can be plain arrays indexed by handle.
+// Handles are never reused; lookups by string_view do not allocate.
+class IdTable {
+private:
+    std::deque<std::string> names;                          // Handle -> ID (deque keeps the strings in place)
+    std::unordered_map<std::string_view, IdHandle> handles; // ID -> handle, keyed by views into names
+
+public:
+    IdHandle intern(std::string_view id);          // Handle of the ID, allocated on first use
+    IdHandle find(std::string_view id) const;      // Handle of the ID, NO_HANDLE if it was never interned
+    const std::string& name(IdHandle handle) const; // ID of a valid handle
+    std::size_t size() const;                      // Number of interned IDs
+    void reserve(std::size_t count);               // Prepares the table for count IDs
+};
+
+#endif // IDTABLE_H
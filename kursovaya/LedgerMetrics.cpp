@@ -0,0 +1,140 @@
+#include "LedgerMetrics.h"
+#include <iomanip>
+
+// Upper bound of a bucket, in ns
+static std::uint64_t bucketLimit(std::size_t bucket) {
+    return bucket == 0 ? 0 : (std::uint64_t(1) << bucket) - 1;
+}
+
+std::uint64_t LatencyHistogram::percentile(double p) const {
+    if (count == 0) return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(p * (count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank)
+            return bucketLimit(i);
+    }
+    return bucketLimit(LATENCY_BUCKETS - 1);
+}
+
+double LatencyHistogram::mean() const {
+    return count ? static_cast<double>(totalNs) / count : 0.0;
+}
+
+LedgerMetrics::LedgerMetrics() {
+    reset();
+}
+
+// Threads get shards round-robin the first time they record
+LedgerMetrics::Shard& LedgerMetrics::local() {
+    static std::atomic<std::size_t> nextShard(0);
+    thread_local std::size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT;
+    return shards[shard];
+}
+
+// Index of the highest set bit plus one, capped at the last bucket
+std::size_t LedgerMetrics::bucketOf(std::uint64_t ns) {
+    std::size_t bucket = 0;
+    while (ns) {
+        ++bucket;
+        ns >>= 1;
+    }
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+void LedgerMetrics::recordOutcome(TxStatus status) {
+    local().outcomes[static_cast<std::size_t>(status)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LedgerMetrics::recordValidate(std::uint64_t ns) {
+    Shard& shard = local();
+    shard.validate[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    shard.validateNs.fetch_add(ns, std::memory_order_relaxed);
+}
+
+void LedgerMetrics::recordApply(std::uint64_t ns) {
+    Shard& shard = local();
+    shard.apply[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    shard.applyNs.fetch_add(ns, std::memory_order_relaxed);
+}
+
+// Adds one shard's buckets to a histogram
+void LedgerMetrics::collectHistogram(const std::atomic<std::uint64_t>* source, LatencyHistogram& target) {
+    for (std::size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+        std::uint64_t value = source[i].load(std::memory_order_relaxed);
+        target.buckets[i] += value;
+        target.count += value;
+    }
+}
+
+void LedgerMetrics::collect(MetricsSnapshot& snapshot) const {
+    snapshot.validate = LatencyHistogram{};
+    snapshot.apply = LatencyHistogram{};
+    for (std::size_t s = 0; s < TX_STATUS_COUNT; ++s)
+        snapshot.outcomes[s] = 0;
+
+    for (const Shard& shard : shards) {
+        for (std::size_t s = 0; s < TX_STATUS_COUNT; ++s)
+            snapshot.outcomes[s] += shard.outcomes[s].load(std::memory_order_relaxed);
+        collectHistogram(shard.validate, snapshot.validate);
+        collectHistogram(shard.apply, snapshot.apply);
+        snapshot.validate.totalNs += shard.validateNs.load(std::memory_order_relaxed);
+        snapshot.apply.totalNs += shard.applyNs.load(std::memory_order_relaxed);
+    }
+}
+
+void LedgerMetrics::reset() {
+    for (Shard& shard : shards) {
+        for (auto& counter : shard.outcomes) counter.store(0, std::memory_order_relaxed);
+        for (auto& counter : shard.validate) counter.store(0, std::memory_order_relaxed);
+        for (auto& counter : shard.apply) counter.store(0, std::memory_order_relaxed);
+        shard.validateNs.store(0, std::memory_order_relaxed);
+        shard.applyNs.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* txStatusName(TxStatus status) {
+    switch (status) {
+        case TxStatus::OK:                 return "ok";
+        case TxStatus::WALLET_NOT_FOUND:   return "wallet_not_found";
+        case TxStatus::CLIENT_NOT_FOUND:   return "client_not_found";
+        case TxStatus::LIMIT_EXCEEDED:     return "limit_exceeded";
+        case TxStatus::INSUFFICIENT_FUNDS: return "insufficient_funds";
+        case TxStatus::WITHDRAW_FAILED:    return "withdraw_failed";
+        case TxStatus::DUPLICATE_ID:       return "duplicate_id";
+        case TxStatus::LOG_FAILED:         return "log_failed";
+        case TxStatus::INVALID_AMOUNT:     return "invalid_amount";
+    }
+    return "unknown";
+}
+
+// Prints one histogram line: samples, mean and percentiles
+static void printHistogram(std::ostream& out, const char* name, const LatencyHistogram& histogram) {
+    out << "  " << std::left << std::setw(10) << name << std::right
+        << std::setw(12) << histogram.count
+        << std::setw(12) << static_cast<std::uint64_t>(histogram.mean())
+        << std::setw(12) << histogram.percentile(0.50)
+        << std::setw(12) << histogram.percentile(0.99)
+        << std::setw(12) << histogram.percentile(0.999) << "\n";
+}
+
+void printMetrics(std::ostream& out, const MetricsSnapshot& snapshot) {
+    out << "Transactions by outcome:\n";
+    for (std::size_t s = 0; s < TX_STATUS_COUNT; ++s) {
+        out << "  " << std::left << std::setw(20) << txStatusName(static_cast<TxStatus>(s)) << std::right
+            << std::setw(12) << snapshot.outcomes[s] << "\n";
+    }
+
+    out << "Latency (ns, percentiles are bucket upper bounds):\n";
+    out << "  " << std::left << std::setw(10) << "phase" << std::right << std::setw(12) << "samples"
+        << std::setw(12) << "mean" << std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12) << "p99.9" << "\n";
+    printHistogram(out, "validate", snapshot.validate);
+    printHistogram(out, "apply", snapshot.apply);
+
+    out << "Sizes:\n";
+    out << "  clients              " << snapshot.clients << "\n";
+    out << "  wallets              " << snapshot.wallets << "\n";
+    out << "  transactions         " << snapshot.transactions << " (" << snapshot.transactionSlots << " slots)\n";
+    out << "  blocks               " << snapshot.blocks << " (" << snapshot.pendingTransactions << " transactions pending)\n";
+}
@@ -0,0 +1,80 @@
+#ifndef LEDGERMETRICS_H
+#define LEDGERMETRICS_H
+
+#include "TxStatus.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Latency buckets: bucket 0 holds 0 ns, bucket i holds [2^(i-1), 2^i) ns, the last one everything above
+const std::size_t LATENCY_BUCKETS = 40;
+
+// Aggregated latency distribution of one phase
+struct LatencyHistogram {
+    std::uint64_t buckets[LATENCY_BUCKETS];
+    std::uint64_t count;     // Samples recorded
+    std::uint64_t totalNs;   // Sum of the samples
+
+    std::uint64_t percentile(double p) const;  // Upper bound (ns) of the bucket holding the p-quantile
+    double mean() const;                       // Mean latency in ns
+};
+
+// Point-in-time view of the ledger metrics (counters, histograms and size gauges)
+struct MetricsSnapshot {
+    std::uint64_t outcomes[TX_STATUS_COUNT];  // Transactions by TxStatus
+    LatencyHistogram validate;                // Wallet lookup, limit and funds checks
+    LatencyHistogram apply;                   // Fund movement, client index, store and log append
+
+    // Gauges, read from the ledger structures when the snapshot is taken
+    std::size_t clients;
+    std::size_t wallets;
+    std::size_t transactions;
+    std::size_t transactionSlots;             // Including removed transactions
+    std::size_t blocks;
+    std::size_t pendingTransactions;          // Committed but not sealed into a block yet
+};
+
+// Transaction counters and latency histograms of a ledger.
+// Each thread records into its own cache-line-aligned shard with relaxed atomic adds, so the
+// transaction path neither locks nor shares cache lines with other writers; collect() sums the
+// shards. Threads beyond SHARD_COUNT share shards, which stays correct, only less isolated.
+class LedgerMetrics {
+private:
+    static const std::size_t SHARD_COUNT = 16;
+
+    struct alignas(64) Shard {
+        std::atomic<std::uint64_t> outcomes[TX_STATUS_COUNT];
+        std::atomic<std::uint64_t> validate[LATENCY_BUCKETS];
+        std::atomic<std::uint64_t> apply[LATENCY_BUCKETS];
+        std::atomic<std::uint64_t> validateNs;
+        std::atomic<std::uint64_t> applyNs;
+    };
+
+    Shard shards[SHARD_COUNT];
+
+    Shard& local();                                        // Shard of the calling thread
+    static std::size_t bucketOf(std::uint64_t ns);         // Histogram bucket of a latency
+    static void collectHistogram(const std::atomic<std::uint64_t>* source, LatencyHistogram& target);
+
+public:
+    LedgerMetrics();
+
+    LedgerMetrics(const LedgerMetrics&) = delete;
+    LedgerMetrics& operator=(const LedgerMetrics&) = delete;
+
+    void recordOutcome(TxStatus status);
+    void recordValidate(std::uint64_t ns);
+    void recordApply(std::uint64_t ns);
+
+    void collect(MetricsSnapshot& snapshot) const;  // Fills the counters and histograms (not the gauges)
+    void reset();                                   // Zeroes every counter
+};
+
+// Short name of a status for reports ("ok", "insufficient_funds", ...)
+const char* txStatusName(TxStatus status);
+
+// Writes a human-readable dump of a snapshot
+void printMetrics(std::ostream& out, const MetricsSnapshot& snapshot);
+
+#endif // LEDGERMETRICS_H
@@ -0,0 +1,138 @@
+#include "LedgerParser.h"
+#include <charconv>
+#include <cstring>
+
+// Splits a line on ';' into at most maxFields views; returns the number of fields found.
+// If the line has more separators than maxFields allows, maxFields + 1 is returned.
+static std::size_t splitFields(std::string_view line, std::string_view* fields, std::size_t maxFields) {
+    std::size_t count = 0;
+    const char* p = line.data();
+    const char* last = p + line.size();
+    while (count < maxFields) {
+        const char* sep = static_cast<const char*>(std::memchr(p, ';', last - p));
+        if (!sep) {
+            fields[count++] = std::string_view(p, last - p);
+            return count;
+        }
+        fields[count++] = std::string_view(p, sep - p);
+        p = sep + 1;
+    }
+    return count + 1;
+}
+
+// Parses a whole field as an unsigned decimal integer (no sign, also for a signed T)
+template <typename T>
+static bool parseUnsigned(std::string_view field, T& value) {
+    const char* first = field.data();
+    const char* last = first + field.size();
+    if (first == last || *first == '-')
+        return false;
+    auto result = std::from_chars(first, last, value);
+    return result.ec == std::errc() && result.ptr == last && first != last;
+}
+
+// Strips surrounding spaces and tabs
+static std::string_view trim(std::string_view field) {
+    while (!field.empty() && (field.front() == ' ' || field.front() == '\t')) field.remove_prefix(1);
+    while (!field.empty() && (field.back() == ' ' || field.back() == '\t')) field.remove_suffix(1);
+    return field;
+}
+
+LedgerParser::LedgerParser() : cursor(nullptr), end(nullptr), lineNumber(0) {}
+
+// Maps the file and positions the cursor at its first byte
+bool LedgerParser::open(const std::string& filename) {
+    if (!file.open(filename)) return false;
+    cursor = file.getData();
+    end = cursor + file.getSize();
+    lineNumber = 0;
+    errors.clear();
+    return true;
+}
+
+// Returns the next non-empty line, without "\n" or "\r\n"
+bool LedgerParser::nextLine(std::string_view& line) {
+    while (cursor && cursor < end) {
+        const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        const char* lineEnd = newline ? newline : end;
+        const char* start = cursor;
+        cursor = newline ? newline + 1 : end;
+        ++lineNumber;
+
+        std::size_t length = lineEnd - start;
+        if (length > 0 && start[length - 1] == '\r') --length;
+        if (length == 0) continue;
+
+        line = std::string_view(start, length);
+        return true;
+    }
+    return false;
+}
+
+// Records an error for the line returned last
+void LedgerParser::reportError(const std::string& message) {
+    errors.push_back({lineNumber, message});
+}
+
+std::size_t LedgerParser::getLineNumber() const {
+    return lineNumber;
+}
+
+const std::vector<ParseError>& LedgerParser::getErrors() const {
+    return errors;
+}
+
+// Wallet lines start with the "W;" marker
+bool LedgerParser::isWalletRecord(std::string_view line) {
+    return line.size() >= 2 && line[0] == 'W' && line[1] == ';';
+}
+
+// Parses "id;name;type"
+bool LedgerParser::parseClientRecord(std::string_view line, ClientRecord& record) {
+    std::string_view fields[3];
+    if (splitFields(line, fields, 3) != 3 || fields[0].empty()) return false;
+    record.id = fields[0];
+    record.name = fields[1];
+    record.type = trim(fields[2]);
+    return true;
+}
+
+// Parses "W;id;balance"
+bool LedgerParser::parseWalletRecord(std::string_view line, WalletRecord& record) {
+    std::string_view fields[3];
+    if (splitFields(line, fields, 3) != 3 || fields[1].empty()) return false;
+    record.id = fields[1];
+    return parseMoney(fields[2], record.balance);
+}
+
+// Parses "id;sender;recipient;amount;commission[;timestamp[;type]]"; lines written before
+// timestamps were recorded have five fields, and plain transfers are written without a type
+bool LedgerParser::parseTransactionRecord(std::string_view line, TransactionRecord& record) {
+    std::string_view fields[7];
+    std::size_t count = splitFields(line, fields, 7);
+    if (count < 5 || count > 7 || fields[0].empty() || fields[1].empty() || fields[2].empty())
+        return false;
+    record.id = fields[0];
+    record.senderWalletId = fields[1];
+    record.recipientWalletId = fields[2];
+    record.timestamp = 0;
+    if (count >= 6 && !parseUnsigned(trim(fields[5]), record.timestamp))
+        return false;
+    record.type = TxType::TRANSFER;
+    if (count == 7) {
+        std::string_view type = trim(fields[6]);
+        if (type.size() != 1 || !txTypeFromCode(type[0], record.type)) return false;
+    }
+    return parseMoney(fields[3], record.amount) && parseMoney(fields[4], record.commission);
+}
+
+// Parses "index;firstSlot;txCount;previousHash;merkleRoot;hash"
+bool LedgerParser::parseBlockRecord(std::string_view line, BlockRecord& record) {
+    std::string_view fields[6];
+    if (splitFields(line, fields, 6) != 6) return false;
+    record.previousHash = fields[3];
+    record.merkleRoot = fields[4];
+    record.hash = fields[5];
+    return parseUnsigned(fields[0], record.index) && parseUnsigned(fields[1], record.firstSlot) &&
+           parseUnsigned(fields[2], record.txCount);
+}
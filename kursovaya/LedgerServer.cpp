@@ -0,0 +1,410 @@
+#include "LedgerServer.h"
+#include "LedgerMetrics.h"
+#include <iostream>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Output kept per connection before it stops being read
+static const std::size_t MAX_PENDING_OUTPUT = 1 << 20;
+// Longest request line; a connection that sends more without a newline is closed
+static const std::size_t MAX_LINE = 1 << 16;
+
+LedgerServer::LedgerServer(Blockchain& ledger)
+    : ledger(ledger), listenFd(-1), epollFd(-1), wakeFd(-1), stats{0, 0, 0, 0},
+      checkpoints(nullptr) {}
+
+void LedgerServer::setCheckpoints(CheckpointManager* manager) {
+    checkpoints = manager;
+}
+
+const ServerStats& LedgerServer::getStats() const {
+    return stats;
+}
+
+#ifdef __linux__
+
+LedgerServer::~LedgerServer() {
+    for (auto& entry : connections)
+        ::close(entry.first);
+    if (listenFd >= 0) ::close(listenFd);
+    if (epollFd >= 0) ::close(epollFd);
+    if (wakeFd >= 0) ::close(wakeFd);
+    if (!unixPath.empty()) ::unlink(unixPath.c_str());
+}
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Registers a bound socket with a fresh epoll instance
+bool LedgerServer::startListening(int fd) {
+    if (::listen(fd, SOMAXCONN) != 0 || !setNonBlocking(fd)) {
+        std::cerr << "listen: " << std::strerror(errno) << "\n";
+        ::close(fd);
+        return false;
+    }
+    listenFd = fd;
+    epollFd = epoll_create1(0);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    return epollFd >= 0 && epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) == 0;
+}
+
+bool LedgerServer::listenTcp(std::uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "bind 127.0.0.1:" << port << ": " << std::strerror(errno) << "\n";
+        ::close(fd);
+        return false;
+    }
+    return startListening(fd);
+}
+
+bool LedgerServer::listenUnix(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) return false;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "bind " << path << ": " << std::strerror(errno) << "\n";
+        ::close(fd);
+        return false;
+    }
+    unixPath = path;
+    return startListening(fd);
+}
+
+void LedgerServer::acceptConnections() {
+    while (true) {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) return;  // EAGAIN: all pending connections taken
+        setNonBlocking(fd);
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));  // Fails harmlessly on Unix sockets
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        connections[fd] = Connection{std::string(), std::string(), std::deque<HeldAnswers>(), EPOLLIN, false};
+        stats.connections++;
+    }
+}
+
+void LedgerServer::readConnection(int fd, Connection& connection) {
+    if (connection.closing) return;  // Nothing more is executed for it
+    char buffer[65536];
+    ssize_t n = ::read(fd, buffer, sizeof(buffer));
+    if (n > 0) {
+        connection.input.append(buffer, static_cast<std::size_t>(n));
+        ready.push_back(fd);
+    } else if (n == 0) {
+        connection.closing = true;  // Still answers what it sent
+        writeConnection(fd, connection);
+    } else if (errno != EAGAIN && errno != EINTR) {
+        connection.output.clear();
+        connection.held.clear();
+        connection.closing = true;
+    }
+}
+
+// Splits a line on single spaces into at most maxFields fields; returns the number found
+static std::size_t splitWords(std::string_view line, std::string_view* fields, std::size_t maxFields) {
+    std::size_t count = 0;
+    while (!line.empty() && count < maxFields) {
+        std::size_t space = line.find(' ');
+        fields[count++] = line.substr(0, space);
+        if (space == std::string_view::npos) return count;
+        line.remove_prefix(space + 1);
+    }
+    return line.empty() ? count : maxFields + 1;
+}
+
+void LedgerServer::executeRequests(int fd, Connection& connection) {
+    std::size_t start = 0;
+    while (true) {
+        std::size_t newline = connection.input.find('\n', start);
+        if (newline == std::string::npos) break;
+        std::string_view line(connection.input.data() + start, newline - start);
+        start = newline + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+
+        std::string_view fields[5];
+        std::size_t count = splitWords(line, fields, 5);
+        Money amount;
+        if (count == 5 && fields[0] == "T" && parseMoney(fields[4], amount) && isRecordField(fields[1]) &&
+            isRecordField(fields[2]) && isRecordField(fields[3])) {
+            std::string sender(fields[2]);
+            const WalletRef* ref = ledger.findWalletRef(sender);
+            Money commission = ref && ref->owner ? ref->owner->calculateCommission(amount) : 0;
+            pending.push_back({fd, new Transaction(std::string(fields[1]), std::move(sender), std::string(fields[3]),
+                                                   amount, TxType::TRANSFER, commission)});
+            continue;
+        }
+
+        stats.requests++;
+        if (count == 2 && fields[0] == "B") {
+            flushTransfers();  // The query must see the transfers sent before it
+            std::string walletId(fields[1]);
+            const Wallet* wallet = ledger.findWalletById(walletId);
+            answer(fd, connection, 0, wallet ? "BAL " + walletId + " " + formatMoney(wallet->getBalance()) + "\n"
+                                             : "ERR " + walletId + " wallet_not_found\n");
+        } else {
+            flushTransfers();  // Keep the answers in request order
+            answer(fd, connection, 0, "ERR - malformed\n");
+        }
+    }
+    connection.input.erase(0, start);
+    if (connection.input.size() > MAX_LINE) {
+        flushTransfers();
+        answer(fd, connection, 0, "ERR - malformed\n");
+        connection.input.clear();
+        connection.closing = true;
+    }
+}
+
+void LedgerServer::flushTransfers() {
+    if (pending.empty()) return;
+    std::vector<Transaction*> batch(pending.size());
+    for (std::size_t i = 0; i < pending.size(); ++i)
+        batch[i] = pending[i].tx;
+    // Read the IDs first: accepted transactions are taken over by the ledger
+    std::vector<std::string> ids(pending.size());
+    for (std::size_t i = 0; i < pending.size(); ++i)
+        ids[i] = pending[i].tx->getId();
+
+    std::vector<TxStatus> statuses = ledger.processTransactions(batch.data(), batch.size());
+    std::uint64_t ticket = ledger.getLogTicket();  // 0 unless a group-commit log is open
+    stats.batches++;
+    stats.transfers += batch.size();
+    stats.requests += batch.size();
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+        auto found = connections.find(pending[i].fd);
+        if (statuses[i] != TxStatus::OK)
+            delete batch[i];
+        if (found == connections.end()) continue;
+        if (statuses[i] == TxStatus::OK)
+            answer(found->first, found->second, ticket, "OK " + ids[i] + "\n");
+        else
+            answer(found->first, found->second, ticket, "ERR " + ids[i] + " " + txStatusName(statuses[i]) + "\n");
+    }
+    pending.clear();
+}
+
+void LedgerServer::answer(int fd, Connection& connection, std::uint64_t ticket, const std::string& text) {
+    if (connection.held.empty()) {
+        if (ticket == 0 || ticket <= ledger.getGroupCommitLog().getDurable()) {
+            connection.output += text;
+            return;
+        }
+        holding.push_back(fd);
+    }
+    // Tickets only grow, and an answer never overtakes the ones held before it
+    if (connection.held.empty() || ticket > connection.held.back().ticket)
+        connection.held.push_back(HeldAnswers{ticket, text});
+    else
+        connection.held.back().text += text;
+}
+
+void LedgerServer::releaseDurable() {
+    if (holding.empty()) return;
+    std::uint64_t durable = ledger.getGroupCommitLog().getDurable();
+    std::size_t kept = 0;
+    for (int fd : holding) {
+        auto found = connections.find(fd);
+        if (found == connections.end()) continue;
+        Connection& connection = found->second;
+        bool released = false;
+        while (!connection.held.empty() && connection.held.front().ticket <= durable) {
+            connection.output += connection.held.front().text;
+            connection.held.pop_front();
+            released = true;
+        }
+        if (released)
+            writeConnection(fd, connection);
+        if (!connection.held.empty())
+            holding[kept++] = fd;
+    }
+    holding.resize(kept);
+}
+
+void LedgerServer::writeConnection(int fd, Connection& connection) {
+    while (!connection.output.empty()) {
+        ssize_t n = ::write(fd, connection.output.data(), connection.output.size());
+        if (n <= 0) {
+            if (n < 0 && (errno == EAGAIN || errno == EINTR)) break;
+            connection.output.clear();
+            connection.held.clear();
+            connection.closing = true;
+            return;
+        }
+        connection.output.erase(0, static_cast<std::size_t>(n));
+    }
+    // Read only while the peer is there and its answers are not piling up (backpressure)
+    std::uint32_t events = 0;
+    if (!connection.closing && connection.output.size() <= MAX_PENDING_OUTPUT)
+        events |= EPOLLIN;
+    if (!connection.output.empty())
+        events |= EPOLLOUT;
+    if (events != connection.events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+        connection.events = events;
+    }
+}
+
+void LedgerServer::closeConnection(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+}
+
+// Lets the group-commit writer wake the loop when a group becomes durable
+bool LedgerServer::watchGroupCommit() {
+    GroupCommitLog& groupLog = ledger.getGroupCommitLog();
+    if (!groupLog.isOpen()) return true;
+    if (wakeFd < 0) {
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wakeFd;
+        if (wakeFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) != 0)
+            return false;
+    }
+    int fd = wakeFd;
+    groupLog.setDurableCallback([fd](std::uint64_t) {
+        std::uint64_t one = 1;
+        ssize_t written = ::write(fd, &one, sizeof(one));
+        (void)written;  // A full counter still wakes the loop
+    });
+    return true;
+}
+
+bool LedgerServer::run(const volatile std::sig_atomic_t& stop) {
+    if (listenFd < 0) return false;
+    if (!watchGroupCommit()) {
+        std::cerr << "eventfd: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    bool ok = serve(stop);
+    ledger.getGroupCommitLog().setDurableCallback(nullptr);
+    if (ok && ledger.syncLog()) {
+        releaseDurable();  // Best effort: the held answers of the last groups
+    }
+    return ok;
+}
+
+bool LedgerServer::serve(const volatile std::sig_atomic_t& stop) {
+    const int MAX_EVENTS = 256;
+    epoll_event events[MAX_EVENTS];
+    std::vector<int> writable;
+    while (!stop) {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, 100);
+        if (count < 0 && errno != EINTR) {
+            std::cerr << "epoll_wait: " << std::strerror(errno) << "\n";
+            return false;
+        }
+        if (ledger.getGroupCommitLog().hasFailed()) {
+            std::cerr << "The write-ahead log failed; stopping so no more commits are acknowledged\n";
+            return false;
+        }
+
+        // Gather: read everything the ready connections sent
+        ready.clear();
+        writable.clear();
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptConnections();
+                continue;
+            }
+            if (fd == wakeFd) {
+                std::uint64_t counter;
+                ssize_t drained = ::read(wakeFd, &counter, sizeof(counter));
+                (void)drained;  // Released below, whatever the count
+                continue;
+            }
+            auto found = connections.find(fd);
+            if (found == connections.end()) continue;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                readConnection(fd, found->second);
+            if (events[i].events & EPOLLOUT)
+                writable.push_back(fd);
+        }
+
+        // Execute: requests in arrival order, transfers batched across connections
+        for (int fd : ready)
+            executeRequests(fd, connections[fd]);
+        flushTransfers();
+        releaseDurable();
+        if (checkpoints)
+            checkpoints->maybeCheckpoint();
+
+        // Answer, then drop the connections that went away
+        for (int fd : ready)
+            writeConnection(fd, connections[fd]);
+        for (int fd : writable) {
+            auto found = connections.find(fd);
+            if (found != connections.end())
+                writeConnection(fd, found->second);
+        }
+        for (auto entry = connections.begin(); entry != connections.end();) {
+            int fd = entry->first;
+            ++entry;
+            const Connection& connection = connections[fd];
+            if (connection.closing && connection.output.empty() && connection.held.empty())
+                closeConnection(fd);
+        }
+    }
+    return true;
+}
+
+#else  // Not Linux: no epoll
+
+LedgerServer::~LedgerServer() {}
+
+bool LedgerServer::startListening(int) { return false; }
+bool LedgerServer::listenTcp(std::uint16_t) {
+    std::cerr << "The server mode needs Linux (epoll).\n";
+    return false;
+}
+bool LedgerServer::listenUnix(const std::string& path) { return listenTcp(0) && !path.empty(); }
+void LedgerServer::acceptConnections() {}
+void LedgerServer::readConnection(int, Connection&) {}
+void LedgerServer::executeRequests(int, Connection&) {}
+void LedgerServer::flushTransfers() {}
+void LedgerServer::answer(int, Connection&, std::uint64_t, const std::string&) {}
+void LedgerServer::releaseDurable() {}
+void LedgerServer::writeConnection(int, Connection&) {}
+void LedgerServer::closeConnection(int) {}
+bool LedgerServer::watchGroupCommit() { return false; }
+bool LedgerServer::serve(const volatile std::sig_atomic_t&) { return false; }
+bool LedgerServer::run(const volatile std::sig_atomic_t&) { return false; }
+
+#endif
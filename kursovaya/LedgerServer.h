@@ -0,0 +1,107 @@
+#ifndef LEDGERSERVER_H
+#define LEDGERSERVER_H
+
+#include "Blockchain.h"
+#include "CheckpointManager.h"
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Line protocol, one request per line, answered in order on each connection. Clients may
+// pipeline: send many requests without waiting for the answers.
+//   T <id> <sender wallet> <recipient wallet> <amount>  ->  OK <id>  |  ERR <id> <status>
+//   B <wallet>                                           ->  BAL <wallet> <balance>  |  ERR <wallet> wallet_not_found
+// The commission is charged by the server from the sender's tier. <status> is a txStatusName,
+// and a line that is not a request is answered with "ERR - malformed", as is a transfer whose ID
+// or wallet IDs hold ';' or control characters (they could not be logged). A connection that
+// sends more than 64 KB without a newline gets "ERR - malformed" and is closed.
+
+// Counters of a server run
+struct ServerStats {
+    std::uint64_t connections;  // Connections accepted
+    std::uint64_t requests;     // Requests answered
+    std::uint64_t batches;      // processTransactions calls
+    std::uint64_t transfers;    // Transfers handed to the ledger
+};
+
+// Single-threaded epoll front end for a Blockchain (Linux only; elsewhere listen fails).
+// Every turn of the event loop reads what the ready connections sent, then executes the complete
+// requests in arrival order: consecutive transfers, from all connections, go to the ledger as one
+// processTransactions batch (one log flush per batch), and a balance query first flushes the
+// transfers before it, so each connection reads its own writes. Answers are written back without
+// blocking; a connection with too much unsent output is not read until it drains.
+// With a group-commit log open on the ledger, the answers to a batch are held until the writer
+// thread reports the batch durable (through an eventfd the loop waits on), so an OK is only sent
+// for a transfer that is on disk; later answers of the same connection wait behind it.
+class LedgerServer {
+private:
+    // Answers waiting for the log to become durable up to their ticket
+    struct HeldAnswers {
+        std::uint64_t ticket;
+        std::string text;
+    };
+
+    // One client connection
+    struct Connection {
+        std::string input;     // Bytes received and not yet parsed
+        std::string output;    // Answers not yet written
+        std::deque<HeldAnswers> held;  // Answers not released yet, in request order
+        std::uint32_t events;  // epoll events the connection is registered for
+        bool closing;          // Peer closed (dropped once its answers are written) or failed
+    };
+
+    // A transfer waiting for the batch it belongs to
+    struct PendingTransfer {
+        int fd;                // Connection to answer
+        Transaction* tx;       // Heap transaction handed to processTransactions
+    };
+
+    Blockchain& ledger;
+    int listenFd;
+    int epollFd;
+    int wakeFd;                // eventfd signalled by the group-commit writer (-1 without one)
+    std::string unixPath;      // Socket file to remove on shutdown (Unix socket only)
+    std::unordered_map<int, Connection> connections;
+    std::vector<PendingTransfer> pending;
+    std::vector<int> ready;    // Connections with complete requests this turn, in reading order
+    std::vector<int> holding;  // Connections that may have held answers
+    ServerStats stats;
+    CheckpointManager* checkpoints;  // Offered a checkpoint after each batch (optional)
+
+    bool startListening(int fd);
+    void acceptConnections();
+    void readConnection(int fd, Connection& connection);
+    void executeRequests(int fd, Connection& connection);   // Parses and runs the complete lines
+    void flushTransfers();                                  // Commits the pending transfers as one batch
+    // Queues an answer, held back while the log is not durable up to ticket or earlier answers wait
+    void answer(int fd, Connection& connection, std::uint64_t ticket, const std::string& text);
+    void releaseDurable();                                  // Moves the answers now durable to the output
+    void writeConnection(int fd, Connection& connection);   // Writes what it can and updates the events
+    void closeConnection(int fd);
+    bool watchGroupCommit();                                // Hooks the wake-up eventfd to the ledger's group-commit log
+    bool serve(const volatile std::sig_atomic_t& stop);     // The event loop of run
+
+public:
+    explicit LedgerServer(Blockchain& ledger);
+    ~LedgerServer();
+
+    LedgerServer(const LedgerServer&) = delete;
+    LedgerServer& operator=(const LedgerServer&) = delete;
+
+    bool listenTcp(std::uint16_t port);          // 127.0.0.1:port
+    bool listenUnix(const std::string& path);    // Unix stream socket at path (replaces a stale one)
+
+    // Serves until stop becomes non-zero (checked at least every 100 ms); false if not listening
+    bool run(const volatile std::sig_atomic_t& stop);
+
+    // Checkpoints of the ledger: maybeCheckpoint() runs after each batch of transfers (nullptr = none)
+    void setCheckpoints(CheckpointManager* manager);
+
+    const ServerStats& getStats() const;
+};
+
+#endif // LEDGERSERVER_H
@@ -0,0 +1,111 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Constructor creates an empty, closed mapping
+#ifdef _WIN32
+MappedFile::MappedFile() : data(nullptr), size(0), fileHandle(nullptr), mappingHandle(nullptr) {}
+#else
+MappedFile::MappedFile() : data(nullptr), size(0), fd(-1) {}
+#endif
+
+// Destructor releases the mapping
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+// Maps the whole file read-only through a Windows file mapping
+bool MappedFile::open(const std::string& filename) {
+    close();
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        close();
+        return false;
+    }
+    size = static_cast<std::size_t>(fileSize.QuadPart);
+    if (size == 0) return true;  // Empty files cannot be mapped but are valid
+
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        close();
+        return false;
+    }
+    data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Unmaps the view and closes both handles
+void MappedFile::close() {
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    data = nullptr;
+    size = 0;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+
+#else
+
+// Maps the whole file read-only and hints the kernel that it will be read sequentially
+bool MappedFile::open(const std::string& filename) {
+    close();
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close();
+        return false;
+    }
+    size = static_cast<std::size_t>(st.st_size);
+    if (size == 0) return true;  // Empty files cannot be mapped but are valid
+
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(mapped);
+    return true;
+}
+
+// Unmaps the file and closes its descriptor
+void MappedFile::close() {
+    if (data) munmap(const_cast<char*>(data), size);
+    if (fd >= 0) ::close(fd);
+    data = nullptr;
+    size = 0;
+    fd = -1;
+}
+
+#endif
+
+// Returns the mapped bytes
+const char* MappedFile::getData() const {
+    return data;
+}
+
+// Returns the number of mapped bytes
+std::size_t MappedFile::getSize() const {
+    return size;
+}
@@ -0,0 +1,34 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file.
+// Uses mmap on POSIX systems and a file mapping object on Windows.
+class MappedFile {
+private:
+    const char* data;        // Start of the mapped bytes (nullptr for an empty or closed file)
+    std::size_t size;        // Number of mapped bytes
+#ifdef _WIN32
+    void* fileHandle;        // HANDLE of the opened file
+    void* mappingHandle;     // HANDLE of the file mapping object
+#else
+    int fd;                  // Descriptor of the opened file
+#endif
+
+public:
+    MappedFile();            // Constructor creates a closed mapping
+    ~MappedFile();           // Destructor unmaps the file
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename);  // Maps the file; false if it cannot be opened or mapped
+    void close();                            // Unmaps the file
+
+    const char* getData() const;             // Returns the mapped bytes
+    std::size_t getSize() const;             // Returns the number of mapped bytes
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,60 @@
+#include "Money.h"
+#include <charconv>
+#include <limits>
+
+// Digit-by-digit parser with overflow checks; the fraction is padded to two digits
+bool parseMoney(std::string_view text, Money& value) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    const std::int64_t limit = std::numeric_limits<std::int64_t>::max() / MONEY_SCALE - 1;
+    std::int64_t units = 0;
+    int digits = 0;
+    while (p != end && *p >= '0' && *p <= '9') {
+        units = units * 10 + (*p - '0');
+        if (units > limit) return false;
+        ++p;
+        ++digits;
+    }
+
+    std::int64_t cents = 0;
+    int decimals = 0;
+    if (p != end && *p == '.') {
+        ++p;
+        while (p != end && *p >= '0' && *p <= '9') {
+            if (++decimals > 2) return false;
+            cents = cents * 10 + (*p - '0');
+            ++p;
+        }
+        if (decimals == 1) cents *= 10;
+    }
+
+    if (p != end || digits + decimals == 0) return false;
+
+    Money result = units * MONEY_SCALE + cents;
+    value = negative ? -result : result;
+    return true;
+}
+
+std::string formatMoney(Money value) {
+    char buffer[32];
+    char* p = buffer;
+    std::uint64_t magnitude = value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+    if (value < 0) *p++ = '-';
+    p = std::to_chars(p, buffer + sizeof(buffer), magnitude / MONEY_SCALE).ptr;
+    std::uint64_t cents = magnitude % MONEY_SCALE;
+    *p++ = '.';
+    *p++ = static_cast<char>('0' + cents / 10);
+    *p++ = static_cast<char>('0' + cents % 10);
+    return std::string(buffer, p);
+}
+
+Money applyRate(Money amount, std::int64_t basisPoints) {
+    std::int64_t scaled = amount * basisPoints;
+    return scaled >= 0 ? (scaled + 5000) / 10000 : (scaled - 5000) / 10000;
+}
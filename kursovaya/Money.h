@@ -0,0 +1,28 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Monetary amount as a 64-bit fixed-point number of minor units (cents).
+// All balances, amounts, commissions and limits use it, so sums and comparisons are exact.
+typedef std::int64_t Money;
+
+const Money MONEY_SCALE = 100;      // Minor units per major unit (two decimals)
+
+// Builds an amount from whole major units, e.g. money(1000) is 1000.00
+constexpr Money money(std::int64_t units) {
+    return units * MONEY_SCALE;
+}
+
+// Parses "123", "123.4" or "-123.45" exactly; false on anything else, including a third decimal
+bool parseMoney(std::string_view text, Money& value);
+
+// Formats with exactly two decimals ("123.45"), the format used by the ledger files
+std::string formatMoney(Money value);
+
+// Applies a rate expressed in basis points (1/100 of a percent), rounding half away from zero
+Money applyRate(Money amount, std::int64_t basisPoints);
+
+#endif // MONEY_H
@@ -0,0 +1,104 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Slab allocator for objects of one type.
+// Objects are constructed in slabs of SLAB_SIZE slots allocated in one block each; destroyed slots
+// go on a free list and are reused before a new slab is taken. When the pool goes away it destroys
+// the objects still alive in place and releases the slabs. For a trivially destructible T (the
+// ledger's clients, wallets and tree nodes) there is nothing to destroy and teardown is one heap
+// free per slab; otherwise the live objects are walked and free whatever they own.
+// Not thread-safe: the owner serialises create and destroy.
+template <typename T, std::size_t SLAB_SIZE = 1024>
+class ObjectPool {
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];  // The object, or the free-list link while free
+        bool live;                                    // True while an object is constructed here
+    };
+    static_assert(sizeof(T) >= sizeof(Slot*), "a free slot must hold the free-list link");
+
+    std::vector<Slot*> slabs;  // Every slab, in allocation order
+    std::size_t usedInLast;    // Slots handed out from the last slab
+    Slot* freeList;            // Slots whose object was destroyed, most recent first
+    std::size_t liveCount;     // Objects currently alive
+
+    // Free-list link stored in the storage of a free slot
+    static Slot*& nextFree(Slot* slot) { return *reinterpret_cast<Slot**>(slot->storage); }
+
+    // Returns a slot to construct into: a recycled one first, then the next one of the last slab
+    Slot* takeSlot() {
+        if (freeList) {
+            Slot* slot = freeList;
+            freeList = nextFree(slot);
+            return slot;
+        }
+        if (slabs.empty() || usedInLast == SLAB_SIZE) {
+            slabs.push_back(static_cast<Slot*>(::operator new(sizeof(Slot) * SLAB_SIZE)));
+            usedInLast = 0;
+        }
+        return &slabs.back()[usedInLast++];
+    }
+
+    // Puts a slot on the free list
+    void releaseSlot(Slot* slot) {
+        slot->live = false;
+        nextFree(slot) = freeList;
+        freeList = slot;
+    }
+
+public:
+    ObjectPool() : usedInLast(0), freeList(nullptr), liveCount(0) {}
+
+    // The pool owns the storage of its objects, so it cannot be copied
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    ~ObjectPool() {
+        if (!std::is_trivially_destructible<T>::value && liveCount > 0) {
+            for (std::size_t s = 0; s < slabs.size(); ++s) {
+                std::size_t used = s + 1 == slabs.size() ? usedInLast : SLAB_SIZE;
+                for (std::size_t i = 0; i < used; ++i) {
+                    if (slabs[s][i].live)
+                        reinterpret_cast<T*>(slabs[s][i].storage)->~T();
+                }
+            }
+        }
+        for (Slot* slab : slabs)
+            ::operator delete(static_cast<void*>(slab));
+    }
+
+    // Constructs an object in the pool; it stays valid until destroy() or the pool's destruction
+    template <typename... Args>
+    T* create(Args&&... args) {
+        Slot* slot = takeSlot();
+        T* object;
+        try {
+            object = new (slot->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            releaseSlot(slot);
+            throw;
+        }
+        slot->live = true;
+        ++liveCount;
+        return object;
+    }
+
+    // Destroys an object created by this pool and recycles its slot
+    void destroy(T* object) {
+        if (!object) return;
+        object->~T();
+        releaseSlot(reinterpret_cast<Slot*>(object));
+        --liveCount;
+    }
+
+    // Returns the number of live objects
+    std::size_t size() const { return liveCount; }
+};
+
+#endif // OBJECTPOOL_H
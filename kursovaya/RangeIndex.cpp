@@ -0,0 +1,62 @@
+#include "RangeIndex.h"
+#include <algorithm>
+#include <limits>
+
+const Money RangeIndex::EMPTY_AMOUNT = std::numeric_limits<Money>::min();
+
+RangeIndex::RangeIndex() : capacity(0) {}
+
+void RangeIndex::grow() {
+    std::size_t newCapacity = capacity == 0 ? 1024 : capacity * 2;
+    std::vector<Money> tree(2 * newCapacity, EMPTY_AMOUNT);
+    std::copy(maxTree.begin() + capacity, maxTree.begin() + capacity + times.size(), tree.begin() + newCapacity);
+    for (std::size_t node = newCapacity - 1; node > 0; --node)
+        tree[node] = std::max(tree[2 * node], tree[2 * node + 1]);
+    maxTree.swap(tree);
+    capacity = newCapacity;
+}
+
+void RangeIndex::append(Timestamp time, Money amount) {
+    if (times.size() == capacity)
+        grow();
+    std::size_t node = capacity + times.size();
+    times.push_back(times.empty() ? time : std::max(time, times.back()));
+    maxTree[node] = amount;
+    // Appending only ever raises a maximum, so the walk up can stop at the first node it does not raise
+    for (node /= 2; node > 0 && maxTree[node] < amount; node /= 2)
+        maxTree[node] = amount;
+}
+
+std::size_t RangeIndex::size() const {
+    return times.size();
+}
+
+Timestamp RangeIndex::latest() const {
+    return times.empty() ? 0 : times.back();
+}
+
+void RangeIndex::slotRange(Timestamp from, Timestamp to, std::size_t& first, std::size_t& last) const {
+    first = std::lower_bound(times.begin(), times.end(), from) - times.begin();
+    last = from <= to ? std::upper_bound(times.begin() + first, times.end(), to) - times.begin() : first;
+}
+
+void RangeIndex::collect(std::size_t node, std::size_t nodeFirst, std::size_t nodeLast, std::size_t first,
+                         std::size_t last, Money amount, std::vector<std::size_t>& slots) const {
+    if (nodeLast <= first || last <= nodeFirst || maxTree[node] <= amount)
+        return;
+    if (node >= capacity) {
+        slots.push_back(node - capacity);
+        return;
+    }
+    std::size_t middle = nodeFirst + (nodeLast - nodeFirst) / 2;
+    collect(2 * node, nodeFirst, middle, first, last, amount, slots);
+    collect(2 * node + 1, middle, nodeLast, first, last, amount, slots);
+}
+
+std::vector<std::size_t> RangeIndex::slotsAbove(Money amount, std::size_t first, std::size_t last) const {
+    std::vector<std::size_t> slots;
+    last = std::min(last, times.size());
+    if (first < last)
+        collect(1, 0, capacity, first, last, amount, slots);
+    return slots;
+}
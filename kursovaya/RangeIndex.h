@@ -0,0 +1,46 @@
+#ifndef RANGEINDEX_H
+#define RANGEINDEX_H
+
+#include "Money.h"
+#include "Transaction.h"
+#include <cstddef>
+#include <vector>
+
+// Columnar index of the transaction store for time and amount range queries, one entry per slot
+// in commit order:
+//  - a timestamp column kept non-decreasing (an entry never goes below the one before it), so the
+//    slots of a time window are found with two binary searches;
+//  - a max segment tree over the amounts, so the slots of a range holding more than an amount are
+//    found in one descent that skips every subtree whose maximum is too small: the nodes visited
+//    are the ancestors of the k slots reported plus the two range borders, O(log n + k log(n / k)).
+class RangeIndex {
+private:
+    std::vector<Timestamp> times;  // Slot -> commit time, non-decreasing
+    std::vector<Money> maxTree;    // Node i has children 2i and 2i + 1; leaf of slot s is capacity + s
+    std::size_t capacity;          // Leaves of the tree (0 or a power of two)
+
+    // Doubles the leaf count and rebuilds the inner nodes
+    void grow();
+
+    // Appends the slots in [first, last) under node (covering [nodeFirst, nodeLast)) whose amount exceeds amount
+    void collect(std::size_t node, std::size_t nodeFirst, std::size_t nodeLast, std::size_t first,
+                 std::size_t last, Money amount, std::vector<std::size_t>& slots) const;
+
+public:
+    RangeIndex();
+
+    // Indexes the next slot; an empty slot is appended with EMPTY_AMOUNT
+    void append(Timestamp time, Money amount);
+    std::size_t size() const;
+    Timestamp latest() const;  // Indexed time of the last slot, 0 if none
+
+    // Slots [first, last) whose indexed time lies in [from, to]
+    void slotRange(Timestamp from, Timestamp to, std::size_t& first, std::size_t& last) const;
+
+    // Slots of [first, last) whose amount is greater than amount, in slot order
+    std::vector<std::size_t> slotsAbove(Money amount, std::size_t first, std::size_t last) const;
+
+    static const Money EMPTY_AMOUNT;  // Amount of an empty slot, below any real amount
+};
+
+#endif // RANGEINDEX_H
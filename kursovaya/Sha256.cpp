@@ -0,0 +1,132 @@
+#include "Sha256.h"
+#include <algorithm>
+#include <cstring>
+
+static const std::uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline std::uint32_t rotr(std::uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+// Initializes the state with the standard initial hash value
+Sha256::Sha256() : blockLength(0), totalLength(0) {
+    static const std::uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    std::memcpy(state, initial, sizeof(state));
+}
+
+// Runs the 64 rounds of the compression function on one block
+void Sha256::compress(const std::uint8_t* data) {
+    std::uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (std::uint32_t(data[i * 4]) << 24) | (std::uint32_t(data[i * 4 + 1]) << 16) |
+               (std::uint32_t(data[i * 4 + 2]) << 8) | std::uint32_t(data[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i) {
+        std::uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        std::uint32_t ch = (e & f) ^ (~e & g);
+        std::uint32_t t1 = h + s1 + ch + K[i] + w[i];
+        std::uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        std::uint32_t t2 = s0 + maj;
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+// Buffers input and compresses every complete block
+void Sha256::update(const void* data, std::size_t size) {
+    const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+    totalLength += size;
+    if (blockLength > 0) {
+        std::size_t take = std::min(size, sizeof(block) - blockLength);
+        std::memcpy(block + blockLength, p, take);
+        blockLength += take;
+        p += take;
+        size -= take;
+        if (blockLength < sizeof(block)) return;
+        compress(block);
+        blockLength = 0;
+    }
+    while (size >= sizeof(block)) {
+        compress(p);
+        p += sizeof(block);
+        size -= sizeof(block);
+    }
+    std::memcpy(block, p, size);
+    blockLength = size;
+}
+
+// Appends the padding and the bit length, then extracts the big-endian digest
+Hash256 Sha256::finish() {
+    std::uint64_t bits = totalLength * 8;
+    std::uint8_t padding[72] = {0x80};
+    std::size_t padLength = (blockLength < 56) ? 56 - blockLength : 120 - blockLength;
+    for (int i = 0; i < 8; ++i)
+        padding[padLength + i] = static_cast<std::uint8_t>(bits >> (56 - 8 * i));
+    update(padding, padLength + 8);
+
+    Hash256 digest;
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4] = static_cast<std::uint8_t>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<std::uint8_t>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<std::uint8_t>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<std::uint8_t>(state[i]);
+    }
+    *this = Sha256();
+    return digest;
+}
+
+Hash256 Sha256::hash(const void* data, std::size_t size) {
+    Sha256 sha;
+    sha.update(data, size);
+    return sha.finish();
+}
+
+std::string hashToHex(const Hash256& hash) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(64, '0');
+    for (std::size_t i = 0; i < hash.size(); ++i) {
+        text[i * 2] = digits[hash[i] >> 4];
+        text[i * 2 + 1] = digits[hash[i] & 0x0F];
+    }
+    return text;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool hashFromHex(std::string_view text, Hash256& hash) {
+    if (text.size() != 64) return false;
+    for (std::size_t i = 0; i < hash.size(); ++i) {
+        int high = hexValue(text[i * 2]);
+        int low = hexValue(text[i * 2 + 1]);
+        if (high < 0 || low < 0) return false;
+        hash[i] = static_cast<std::uint8_t>(high * 16 + low);
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 32-byte SHA-256 digest
+typedef std::array<std::uint8_t, 32> Hash256;
+
+// Incremental SHA-256 (FIPS 180-4)
+class Sha256 {
+private:
+    std::uint32_t state[8];      // Intermediate hash value
+    std::uint8_t block[64];      // Partially filled input block
+    std::size_t blockLength;     // Bytes currently in block
+    std::uint64_t totalLength;   // Total bytes hashed so far
+
+    void compress(const std::uint8_t* data);  // Processes one 64-byte block
+
+public:
+    Sha256();
+
+    void update(const void* data, std::size_t size);  // Feeds more input
+    Hash256 finish();                                  // Pads, returns the digest and resets
+
+    static Hash256 hash(const void* data, std::size_t size);  // One-shot digest
+};
+
+std::string hashToHex(const Hash256& hash);                 // 64 lowercase hex digits
+bool hashFromHex(std::string_view text, Hash256& hash);     // Parses 64 hex digits
+
+#endif // SHA256_H
@@ -0,0 +1,385 @@
+#include "ShardedLedger.h"
+#include "LedgerParser.h"
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+// FNV-1a: stable across builds and platforms, so the files always map wallets to the same shard
+static std::uint64_t stableHash(const std::string& id) {
+    std::uint64_t hash = 0xCBF29CE484222325ULL;
+    for (unsigned char c : id) {
+        hash ^= c;
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static bool fileExists(const std::string& filename) {
+    std::error_code ec;
+    return std::filesystem::exists(filename, ec);
+}
+
+ShardedLedger::ShardedLedger(std::size_t shardCount, std::string prefix)
+    : prefix(std::move(prefix)), workers(shardCount > 0 ? shardCount : 1) {
+    shards.resize(workers.getThreadCount());
+    for (auto& shard : shards)
+        shard.reset(new Blockchain());
+}
+
+std::string ShardedLedger::snapshotFile(std::size_t shard) const {
+    return prefix + "shard" + std::to_string(shard) + ".snapshot";
+}
+
+std::string ShardedLedger::logFile(std::size_t shard) const {
+    return prefix + "shard" + std::to_string(shard) + "_wal.txt";
+}
+
+std::string ShardedLedger::intentFile() const {
+    return prefix + "intents.txt";
+}
+
+std::size_t ShardedLedger::getShardCount() const {
+    return shards.size();
+}
+
+std::size_t ShardedLedger::shardOfWallet(const std::string& walletId) const {
+    return static_cast<std::size_t>(stableHash(walletId) % shards.size());
+}
+
+std::size_t ShardedLedger::shardOfClient(const std::string& clientId) const {
+    return static_cast<std::size_t>(stableHash(clientId) % shards.size());
+}
+
+Blockchain& ShardedLedger::getShard(std::size_t shard) {
+    return *shards[shard];
+}
+
+bool ShardedLedger::writeIntent(const std::string& record) {
+    return intents.appendRecord(record) && intents.flush();
+}
+
+bool ShardedLedger::writeOutcome(char kind, const std::string& id) {
+    // A lost outcome is harmless: open() resolves the transfer again from the shards
+    if (writeIntent(std::string(1, kind) + ";" + id))
+        return true;
+    std::cerr << intentFile() << ": cannot record the outcome of transfer " << id << "\n";
+    return false;
+}
+
+bool ShardedLedger::open() {
+    bool ok = true;
+    for (std::size_t k = 0; k < shards.size(); ++k) {
+        if (fileExists(snapshotFile(k)) && !shards[k]->loadSnapshot(snapshotFile(k)))
+            ok = false;
+        if (fileExists(logFile(k)))
+            shards[k]->replayLog(logFile(k));
+        if (!shards[k]->openLog(logFile(k)))
+            ok = false;
+    }
+    if (!intents.open(intentFile()))
+        return false;
+    resolveIntents();
+
+    // A cross-shard transfer is stored on both of its shards; the index holds it once
+    for (const auto& shard : shards)
+        shard->forEachCommittedId([this](const std::string& id) { transactionIds.intern(id); });
+    return ok;
+}
+
+bool ShardedLedger::resolveIntents() {
+    LedgerParser parser;
+    if (!parser.open(intentFile()))
+        return true;  // No intent file: nothing was prepared
+
+    // Prepared transfers without an outcome, in intent order
+    std::vector<Transaction> pending;
+    std::unordered_map<std::string, std::size_t> pendingById;
+    std::vector<bool> resolved;
+    std::string_view line;
+    while (parser.nextLine(line)) {
+        char kind = line.size() > 2 && line[1] == ';' ? line[0] : '\0';
+        std::string_view rest = line.substr(2);
+        if (kind == 'P') {
+            TransactionRecord record;
+            if (!LedgerParser::parseTransactionRecord(rest, record)) {
+                parser.reportError("malformed intent record");
+                continue;
+            }
+            pendingById[std::string(record.id)] = pending.size();
+            pending.emplace_back(std::string(record.id), std::string(record.senderWalletId),
+                                 std::string(record.recipientWalletId), record.amount, TxType::TRANSFER,
+                                 record.commission);
+            resolved.push_back(false);
+        } else if (kind == 'C' || kind == 'A') {
+            auto found = pendingById.find(std::string(rest));
+            if (found != pendingById.end())
+                resolved[found->second] = true;
+        } else {
+            parser.reportError("malformed intent record");
+        }
+    }
+    for (const ParseError& error : parser.getErrors())
+        std::cerr << intentFile() << ":" << error.line << ": " << error.message << "\n";
+
+    bool allResolved = true;
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+        if (resolved[i]) continue;
+        Transaction& tx = pending[i];
+        const std::string id = tx.getId();
+        std::size_t from = shardOfWallet(tx.getSenderWalletId());
+        std::size_t to = shardOfWallet(tx.getRecipientWalletId());
+        if (!shards[from]->hasTransaction(id)) {
+            // The debit never committed, so nothing moved
+            allResolved = writeOutcome('A', id) && allResolved;
+            continue;
+        }
+        // Roll forward: the debit is durable, so the credit must follow
+        tx.setType(TxType::CREDIT);
+        TxStatus status = shards[to]->processTransaction(std::move(tx));
+        if (status == TxStatus::OK || status == TxStatus::DUPLICATE_ID) {
+            allResolved = writeOutcome('C', id) && allResolved;
+        } else {
+            std::cerr << intentFile() << ": cannot complete transfer " << id << ": "
+                      << txStatusMessage(status) << "\n";
+            allResolved = false;
+        }
+    }
+    return allResolved;
+}
+
+bool ShardedLedger::save() {
+    // A transfer whose credit failed is retried here; while one stays open the intent log is kept
+    bool resolved = resolveIntents();
+    bool ok = true;
+    for (std::size_t k = 0; k < shards.size(); ++k) {
+        // A crash between the snapshot and the log reset is harmless: replaying the log onto a
+        // snapshot that already holds its transactions skips them as duplicates
+        if (!shards[k]->saveSnapshot(snapshotFile(k)) || !shards[k]->resetLog())
+            ok = false;
+    }
+    if (!resolved) {
+        std::cerr << intentFile() << ": transfers still open, the intent log is kept\n";
+        return false;
+    }
+    return intents.reset() && ok;
+}
+
+bool ShardedLedger::addClient(const std::string& clientId, const std::string& name, ClientTier tier) {
+    return shards[shardOfClient(clientId)]->addClient(clientId, name, tier) != nullptr;
+}
+
+Wallet* ShardedLedger::createWallet(const std::string& clientId, const std::string& walletId, Money balance) {
+    const Client* registered = shards[shardOfClient(clientId)]->findClientById(clientId);
+    Blockchain& shard = *shards[shardOfWallet(walletId)];
+    if (!registered || shard.findWalletById(walletId))
+        return nullptr;
+
+    Client* owner = shard.findClientById(clientId);
+    if (!owner)
+        owner = shard.addClient(clientId, registered->getName(), registered->getTier());
+    return shard.createWallet(owner, walletId, balance);
+}
+
+bool ShardedLedger::loadClientsFromFile(const std::string& filename) {
+    LedgerParser parser;
+    if (!parser.open(filename)) return false;
+
+    std::string_view line;
+    std::string currentClient;  // Empty while the wallets of a skipped client are read
+    while (parser.nextLine(line)) {
+        if (!LedgerParser::isWalletRecord(line)) {
+            ClientRecord record;
+            currentClient.clear();
+            if (!LedgerParser::parseClientRecord(line, record)) {
+                parser.reportError("malformed client record");
+                continue;
+            }
+            ClientTier tier = ClientTier::STANDARD;
+            tierFromName(record.type, tier);
+            if (addClient(std::string(record.id), std::string(record.name), tier))
+                currentClient = std::string(record.id);
+        } else {
+            WalletRecord record;
+            if (!LedgerParser::parseWalletRecord(line, record)) {
+                parser.reportError("malformed wallet record");
+                continue;
+            }
+            if (!currentClient.empty() && !createWallet(currentClient, std::string(record.id), record.balance))
+                parser.reportError("wallet ID already registered, record skipped");
+        }
+    }
+
+    for (const ParseError& error : parser.getErrors())
+        std::cerr << filename << ":" << error.line << ": " << error.message << "\n";
+    return true;
+}
+
+TxStatus ShardedLedger::transferAcrossShards(Transaction&& tx, std::size_t from, std::size_t to) {
+    const std::string id = tx.getId();
+    // Checked up front, so a prepared transfer can always be completed
+    if (!shards[to]->findWalletRef(tx.getRecipientWalletId()))
+        return TxStatus::WALLET_NOT_FOUND;
+
+    Transaction credit(tx);
+    credit.setType(TxType::CREDIT);
+    if (!writeIntent("P;" + formatTransactionRecord(tx))) {
+        // Without its prepared record a crash could not resolve the transfer, so it does not start
+        std::cerr << intentFile() << ": cannot prepare transfer " << id << "\n";
+        return TxStatus::LOG_FAILED;
+    }
+
+    tx.setType(TxType::DEBIT);
+    TxStatus status = shards[from]->processTransaction(std::move(tx));
+    if (status != TxStatus::OK) {
+        tx.setType(TxType::TRANSFER);  // A rejected transaction goes back to the caller as it came
+        writeOutcome('A', id);
+        return status;
+    }
+
+    status = shards[to]->processTransaction(std::move(credit));
+    if (status != TxStatus::OK) {
+        // Only a failing shard gets here. The debit stands, so the ID is taken; the intent stays
+        // open for save() or open() to complete, and the caller gets the transfer back
+        std::cerr << "transfer " << id << ": credit pending: " << txStatusMessage(status) << "\n";
+        transactionIds.intern(id);
+        tx = std::move(credit);
+        tx.setType(TxType::TRANSFER);
+        return status;
+    }
+    writeOutcome('C', id);
+    return TxStatus::OK;
+}
+
+TxStatus ShardedLedger::processTransaction(Transaction&& tx) {
+    if (transactionIds.find(tx.getId()) != NO_HANDLE)
+        return TxStatus::DUPLICATE_ID;
+    const std::string id = tx.getId();
+    std::size_t from = shardOfWallet(tx.getSenderWalletId());
+    std::size_t to = shardOfWallet(tx.getRecipientWalletId());
+    TxStatus status = from == to ? shards[from]->processTransaction(std::move(tx))
+                                 : transferAcrossShards(std::move(tx), from, to);
+    if (status == TxStatus::OK)
+        transactionIds.intern(id);
+    return status;
+}
+
+std::vector<TxStatus> ShardedLedger::processTransactions(Transaction* const* txs, std::size_t count) {
+    std::vector<TxStatus> statuses(count, TxStatus::OK);
+    std::vector<std::vector<Transaction*>> local(shards.size());
+    std::vector<std::vector<std::size_t>> localPositions(shards.size());
+    // Copied, since the shards take the accepted transactions over; IDs already committed on any
+    // shard, or repeated in the batch, never reach a shard
+    std::vector<std::string> ids(count);
+    std::unordered_set<std::string_view> batchIds;
+    batchIds.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        ids[i] = txs[i]->getId();
+        if (transactionIds.find(ids[i]) != NO_HANDLE || !batchIds.insert(ids[i]).second)
+            statuses[i] = TxStatus::DUPLICATE_ID;
+    }
+
+    // Shards share nothing, so each one commits its queued transfers on its own worker
+    auto commitLocal = [&]() {
+        workers.run([&](std::size_t shard) {
+            if (local[shard].empty()) return;
+            std::vector<TxStatus> shardStatuses = shards[shard]->processTransactions(local[shard].data(), local[shard].size());
+            for (std::size_t j = 0; j < shardStatuses.size(); ++j)
+                statuses[localPositions[shard][j]] = shardStatuses[j];
+            local[shard].clear();
+            localPositions[shard].clear();
+        });
+    };
+
+    // Same-shard transfers are queued; a cross-shard one first commits the queues, if one of its
+    // shards has transfers queued before it, so every wallet sees its transfers in input order
+    for (std::size_t i = 0; i < count; ++i) {
+        if (statuses[i] != TxStatus::OK) continue;
+        Transaction* tx = txs[i];
+        std::size_t from = shardOfWallet(tx->getSenderWalletId());
+        std::size_t to = shardOfWallet(tx->getRecipientWalletId());
+        if (from == to) {
+            local[from].push_back(tx);
+            localPositions[from].push_back(i);
+            continue;
+        }
+        if (!local[from].empty() || !local[to].empty())
+            commitLocal();
+        statuses[i] = transferAcrossShards(std::move(*tx), from, to);
+        if (statuses[i] == TxStatus::OK)
+            delete tx;  // Its contents now live in the shards
+    }
+    commitLocal();
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (statuses[i] == TxStatus::OK)
+            transactionIds.intern(ids[i]);
+    }
+    return statuses;
+}
+
+bool ShardedLedger::processTransactionFile(const std::string& filename, ReplayStats& stats, std::size_t batchSize) {
+    stats = ReplayStats{0, 0, 0, 0};
+    LedgerParser parser;
+    if (!parser.open(filename)) return false;
+
+    std::vector<Transaction*> batch;
+    batch.reserve(batchSize);
+    auto flushBatch = [&]() {
+        std::vector<TxStatus> statuses = processTransactions(batch.data(), batch.size());
+        for (std::size_t i = 0; i < statuses.size(); ++i) {
+            if (statuses[i] == TxStatus::OK) {
+                stats.accepted++;
+                continue;
+            }
+            if (statuses[i] == TxStatus::DUPLICATE_ID)
+                stats.duplicates++;
+            else
+                stats.rejected++;
+            delete batch[i];
+        }
+        batch.clear();
+    };
+
+    std::string_view line;
+    while (parser.nextLine(line)) {
+        TransactionRecord record;
+        if (!LedgerParser::parseTransactionRecord(line, record) || record.type != TxType::TRANSFER) {
+            parser.reportError("malformed transaction record");
+            stats.malformed++;
+            continue;
+        }
+        batch.push_back(new Transaction(std::string(record.id), std::string(record.senderWalletId),
+                                        std::string(record.recipientWalletId), record.amount, TxType::TRANSFER,
+                                        record.commission));
+        if (batch.size() == batchSize)
+            flushBatch();
+    }
+    flushBatch();
+
+    for (const ParseError& error : parser.getErrors())
+        std::cerr << filename << ":" << error.line << ": " << error.message << "\n";
+    return true;
+}
+
+Wallet* ShardedLedger::findWalletById(const std::string& walletId) const {
+    return shards[shardOfWallet(walletId)]->findWalletById(walletId);
+}
+
+Money ShardedLedger::getClientTotal(const std::string& clientId) const {
+    Money total = 0;
+    for (const auto& shard : shards) {
+        if (const Client* client = shard->findClientById(clientId))
+            total += client->getTotalBalance();
+    }
+    return total;
+}
+
+std::size_t ShardedLedger::getTransactionCount() const {
+    std::size_t count = 0;
+    for (const auto& shard : shards)
+        count += shard->getMetrics().transactions;
+    return count;
+}
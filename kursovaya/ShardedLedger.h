@@ -0,0 +1,107 @@
+#ifndef SHARDEDLEDGER_H
+#define SHARDEDLEDGER_H
+
+#include "Blockchain.h"
+#include "IdTable.h"
+#include "TransactionLog.h"
+#include "WorkerPool.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Ledger partitioned across independent Blockchain shards.
+// Every wallet lives in the shard picked by the hash of its ID; each shard has its own client
+// index, transaction store, blocks and write-ahead log. A client is registered in its home shard
+// (hash of the client ID) and replicated, with its name and tier, into every shard holding one of
+// its wallets, so its total balance is the sum of its replicas' totals.
+//
+// A transfer between two wallets of one shard commits on that shard like on a plain Blockchain.
+// A transfer across shards is split into a DEBIT half on the sender's shard and a CREDIT half on
+// the recipient's, driven by a two-phase protocol over the intent log:
+//   1. the transfer is appended to the intent log as prepared ("P")
+//   2. the debit commits on the sender's shard (limit and funds checks, withdrawal)
+//   3. the credit commits on the recipient's shard
+//   4. the outcome is appended: completed ("C"), or aborted ("A") if the debit was refused
+// Every step is flushed to its log before the next one starts. After a crash, open() replays the
+// shard logs, then resolves each prepared transfer without an outcome: if the sender's shard holds
+// the debit, the credit is applied (a credit that already committed is a duplicate and changes
+// nothing); otherwise the transfer is aborted. Whatever step a crash interrupts, money is neither
+// created nor lost. A transfer whose prepared record cannot be written is refused as LOG_FAILED.
+// If the credit fails after the debit committed (its shard cannot log), the transfer returns the
+// credit's status and stays prepared: its ID is taken, and save() or the next open() completes it.
+// Transaction IDs are unique across the whole ledger: a ledger-wide index of the committed IDs is
+// checked before a transfer reaches any shard, and rebuilt from the shards by open().
+//
+// Files, for a prefix P: P + "shard<k>.snapshot" (state at the last save), P + "shard<k>_wal.txt"
+// (that shard's committed transactions since) and P + "intents.txt". Clients and wallets reach
+// disk with save(), as with Blockchain.
+// Shards run as threads of one process: processTransactions commits the same-shard transfers of
+// a batch on one worker per shard and drives the cross-shard ones itself, in input order per
+// shard, so a batch gives the same result as committing its transfers one by one. Not
+// thread-safe otherwise.
+class ShardedLedger {
+private:
+    std::vector<std::unique_ptr<Blockchain>> shards;
+    std::string prefix;           // Path prefix of the shard and intent files
+    TransactionLog intents;       // Intent log of cross-shard transfers
+    WorkerPool workers;           // One worker per shard
+    IdTable transactionIds;       // ID of every transfer committed on any shard
+
+    std::string snapshotFile(std::size_t shard) const;
+    std::string logFile(std::size_t shard) const;
+    std::string intentFile() const;
+
+    // Appends an intent record and hands it to the OS
+    bool writeIntent(const std::string& record);
+    // Writes the outcome ('C' or 'A') of a transfer; a failure is reported and left to open()
+    bool writeOutcome(char kind, const std::string& id);
+
+    // Runs the two-phase protocol for a transfer whose wallets are in different shards.
+    // The caller has checked the ID against transactionIds.
+    TxStatus transferAcrossShards(Transaction&& tx, std::size_t from, std::size_t to);
+
+    // Completes or aborts the prepared transfers of the intent file that have no outcome;
+    // false if one of them is still open
+    bool resolveIntents();
+
+public:
+    // shardCount shards (at least one), with their files under prefix
+    ShardedLedger(std::size_t shardCount, std::string prefix);
+
+    ShardedLedger(const ShardedLedger&) = delete;
+    ShardedLedger& operator=(const ShardedLedger&) = delete;
+
+    std::size_t getShardCount() const;
+    std::size_t shardOfWallet(const std::string& walletId) const;
+    std::size_t shardOfClient(const std::string& clientId) const;
+    Blockchain& getShard(std::size_t shard);
+
+    // Recovery and startup: loads each shard's snapshot (if any), replays its log, resolves the
+    // pending cross-shard transfers and opens the logs. Call it once, before any other change.
+    bool open();
+    // Resolves the open transfers, writes every shard's snapshot and empties the shard logs, then
+    // the intent log. False if a step failed; a transfer still open keeps the intent log as it is.
+    bool save();
+
+    bool addClient(const std::string& clientId, const std::string& name, ClientTier tier); // False if the ID exists
+    // Creates a wallet in its shard for a registered client; nullptr if the client is unknown or the wallet exists
+    Wallet* createWallet(const std::string& clientId, const std::string& walletId, Money balance);
+    // Reads a clients file ("id;name;tier" lines, each followed by its "W;id;balance" lines)
+    bool loadClientsFromFile(const std::string& filename);
+
+    // Same contract as Blockchain::processTransaction(Transaction&&)
+    TxStatus processTransaction(Transaction&& tx);
+    // Same ownership contract as Blockchain::processTransactions: accepted transactions are taken
+    // over, rejected ones stay with the caller. Same-shard transfers run in parallel on their
+    // shards; before a cross-shard transfer, the earlier transfers of its two shards are committed.
+    std::vector<TxStatus> processTransactions(Transaction* const* txs, std::size_t count);
+    // Streams a transaction file through processTransactions, batchSize records at a time
+    bool processTransactionFile(const std::string& filename, ReplayStats& stats, std::size_t batchSize = 4096);
+
+    Wallet* findWalletById(const std::string& walletId) const;
+    Money getClientTotal(const std::string& clientId) const;  // Sum over the shards, 0 if unknown
+    std::size_t getTransactionCount() const;                  // Stored records; a cross-shard transfer counts twice
+};
+
+#endif // SHARDEDLEDGER_H
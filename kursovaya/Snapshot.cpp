@@ -0,0 +1,297 @@
+#include "Snapshot.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// CRC-32 lookup table, built on first use (static initialisation runs once, even across threads)
+static const std::uint32_t* crcTable() {
+    static const std::array<std::uint32_t, 256> table = [] {
+        std::array<std::uint32_t, 256> entries{};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+        return entries;
+    }();
+    return table.data();
+}
+
+std::uint32_t crc32(const char* data, std::size_t size) {
+    const std::uint32_t* table = crcTable();
+    std::uint32_t crc = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// ----------- ByteBuffer implementation -----------
+
+void ByteBuffer::putU8(std::uint8_t value) {
+    bytes.push_back(static_cast<char>(value));
+}
+
+void ByteBuffer::putU32(std::uint32_t value) {
+    putBytes(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void ByteBuffer::putU64(std::uint64_t value) {
+    putBytes(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void ByteBuffer::putI64(std::int64_t value) {
+    putBytes(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void ByteBuffer::putBytes(const char* data, std::size_t size) {
+    bytes.insert(bytes.end(), data, data + size);
+}
+
+const char* ByteBuffer::getData() const {
+    return bytes.data();
+}
+
+std::size_t ByteBuffer::getSize() const {
+    return bytes.size();
+}
+
+// ----------- ByteReader implementation -----------
+
+ByteReader::ByteReader() : cursor(nullptr), end(nullptr), ok(true) {}
+
+ByteReader::ByteReader(const char* data, std::size_t size) : cursor(data), end(data + size), ok(true) {}
+
+// Copies size bytes out of the payload, failing instead of reading past its end
+bool ByteReader::take(void* out, std::size_t size) {
+    if (!ok || static_cast<std::size_t>(end - cursor) < size) {
+        ok = false;
+        std::memset(out, 0, size);
+        return false;
+    }
+    std::memcpy(out, cursor, size);
+    cursor += size;
+    return true;
+}
+
+std::uint8_t ByteReader::getU8() {
+    std::uint8_t value;
+    take(&value, sizeof(value));
+    return value;
+}
+
+std::uint32_t ByteReader::getU32() {
+    std::uint32_t value;
+    take(&value, sizeof(value));
+    return value;
+}
+
+std::uint64_t ByteReader::getU64() {
+    std::uint64_t value;
+    take(&value, sizeof(value));
+    return value;
+}
+
+std::int64_t ByteReader::getI64() {
+    std::int64_t value;
+    take(&value, sizeof(value));
+    return value;
+}
+
+double ByteReader::getF64() {
+    double value;
+    take(&value, sizeof(value));
+    return value;
+}
+
+// Returns a view of the next size bytes without copying them
+std::string_view ByteReader::getBytes(std::size_t size) {
+    if (!ok || static_cast<std::size_t>(end - cursor) < size) {
+        ok = false;
+        return std::string_view();
+    }
+    std::string_view view(cursor, size);
+    cursor += size;
+    return view;
+}
+
+bool ByteReader::good() const {
+    return ok;
+}
+
+bool ByteReader::atEnd() const {
+    return cursor == end;
+}
+
+// ----------- StringTable implementation -----------
+
+StringTable::StringTable() : count(0) {}
+
+std::uint32_t StringTable::intern(const std::string& value) {
+    auto it = ids.find(value);
+    if (it != ids.end())
+        return it->second;
+    std::uint32_t id = add(value);
+    ids.emplace(value, id);
+    return id;
+}
+
+std::uint32_t StringTable::add(const std::string& value) {
+    payload.putU32(static_cast<std::uint32_t>(value.size()));
+    payload.putBytes(value.data(), value.size());
+    return count++;
+}
+
+void StringTable::reserve(std::size_t distinct) {
+    ids.reserve(distinct);
+}
+
+ByteBuffer StringTable::encode() const {
+    ByteBuffer section;
+    section.putU32(count);
+    section.putBytes(payload.getData(), payload.getSize());
+    return section;
+}
+
+// ----------- Snapshot file I/O -----------
+
+bool writeSnapshotFile(const std::string& filename, const std::vector<SnapshotSection>& sections, bool sync) {
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (!file) return false;
+
+    ByteBuffer header;
+    header.putU32(SNAPSHOT_MAGIC);
+    header.putU32(SNAPSHOT_VERSION);
+    header.putU32(static_cast<std::uint32_t>(sections.size()));
+    bool ok = fwrite(header.getData(), 1, header.getSize(), file) == header.getSize();
+
+    for (const SnapshotSection& section : sections) {
+        if (!ok) break;
+        ByteBuffer frame;
+        frame.putU32(section.tag);
+        frame.putU64(section.payload.getSize());
+        std::uint32_t checksum = crc32(section.payload.getData(), section.payload.getSize());
+        ok = fwrite(frame.getData(), 1, frame.getSize(), file) == frame.getSize()
+          && fwrite(section.payload.getData(), 1, section.payload.getSize(), file) == section.payload.getSize()
+          && fwrite(&checksum, sizeof(checksum), 1, file) == 1;
+    }
+
+    if (ok && sync) {
+#ifdef _WIN32
+        ok = fflush(file) == 0 && _commit(_fileno(file)) == 0;
+#else
+        ok = fflush(file) == 0 && fsync(fileno(file)) == 0;
+#endif
+    }
+    if (fclose(file) != 0) ok = false;
+    return ok;
+}
+
+// Makes a rename in the directory durable (a no-op where directories cannot be synced)
+static void syncDirectory(const std::filesystem::path& directory) {
+#ifndef _WIN32
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+#else
+    (void)directory;
+#endif
+}
+
+// Renames a synced temporary file over filename; the temporary is removed if written is false
+static bool commitTemporary(const std::string& temporary, const std::string& filename, bool written) {
+    std::error_code ec;
+    if (!written) {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    std::filesystem::rename(temporary, filename, ec);
+    if (ec) {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    syncDirectory(std::filesystem::path(filename).parent_path());
+    return true;
+}
+
+bool replaceSnapshotFile(const std::string& filename, const std::vector<SnapshotSection>& sections) {
+    const std::string temporary = filename + ".tmp";
+    return commitTemporary(temporary, filename, writeSnapshotFile(temporary, sections, true));
+}
+
+bool replaceFile(const std::string& filename, const ByteBuffer& contents) {
+    const std::string temporary = filename + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(contents.getData(), 1, contents.getSize(), file) == contents.getSize();
+#ifdef _WIN32
+    ok = ok && fflush(file) == 0 && _commit(_fileno(file)) == 0;
+#else
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+#endif
+    if (fclose(file) != 0) ok = false;
+    return commitTemporary(temporary, filename, ok);
+}
+
+SnapshotReader::SnapshotReader() : version(0), remainingSections(0) {}
+
+// Maps the snapshot and validates its magic number and version
+bool SnapshotReader::open(const std::string& filename) {
+    if (!file.open(filename)) {
+        error = "cannot open " + filename;
+        return false;
+    }
+    cursor = ByteReader(file.getData(), file.getSize());
+    std::uint32_t magic = cursor.getU32();
+    version = cursor.getU32();
+    remainingSections = cursor.getU32();
+    if (!cursor.good() || magic != SNAPSHOT_MAGIC) {
+        error = "not a ledger snapshot";
+        return false;
+    }
+    if (version == 0 || version > SNAPSHOT_VERSION) {
+        error = "unsupported snapshot version " + std::to_string(version);
+        return false;
+    }
+    return true;
+}
+
+// Returns the next section once its checksum has been verified
+bool SnapshotReader::nextSection(std::uint32_t& tag, ByteReader& payload) {
+    if (remainingSections == 0)
+        return false;
+    --remainingSections;
+
+    tag = cursor.getU32();
+    std::uint64_t length = cursor.getU64();
+    std::string_view bytes = cursor.getBytes(static_cast<std::size_t>(length));
+    std::uint32_t checksum = cursor.getU32();
+    if (!cursor.good()) {
+        error = "truncated snapshot";
+        return false;
+    }
+    if (crc32(bytes.data(), bytes.size()) != checksum) {
+        error = "checksum mismatch in snapshot section";
+        return false;
+    }
+    payload = ByteReader(bytes.data(), bytes.size());
+    return true;
+}
+
+std::uint32_t SnapshotReader::getVersion() const {
+    return version;
+}
+
+const std::string& SnapshotReader::getError() const {
+    return error;
+}
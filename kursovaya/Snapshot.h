@@ -0,0 +1,119 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Binary snapshot file layout (all integers in host byte order, little-endian on supported targets):
+//   header   : magic "KLDG" (u32), format version (u32), section count (u32)
+//   sections : tag (u32), payload length (u64), payload bytes, CRC-32 of the payload (u32)
+// Strings are stored once in a length-prefixed string table section and referenced by index.
+
+const std::uint32_t SNAPSHOT_MAGIC = 0x47444C4B;   // "KLDG"
+const std::uint32_t SNAPSHOT_VERSION = 5;         // 1: amounts as f64, 2: amounts as i64 Money, 3: commit timestamps, 4: transaction types, 5: domain-separated Merkle trees
+
+// Section tags (four ASCII characters read as a little-endian u32)
+const std::uint32_t SECTION_STRINGS = 0x53525453;       // "STRS": u32 count, then (u32 length, bytes) per string
+const std::uint32_t SECTION_CLIENTS = 0x544E4C43;       // "CLNT": clients with tiers and wallets
+const std::uint32_t SECTION_TRANSACTIONS = 0x534E5854;  // "TXNS": transaction log in append order
+const std::uint32_t SECTION_BLOCKS = 0x534B4C42;        // "BLKS": sealed block headers
+const std::uint32_t SECTION_CHECKPOINT = 0x54504B43;    // "CKPT": u64 first log segment not covered, i64 time taken (ms)
+
+// Computes the CRC-32 (IEEE 802.3) of a byte range
+std::uint32_t crc32(const char* data, std::size_t size);
+
+// Append-only byte buffer used to encode a section payload
+class ByteBuffer {
+private:
+    std::vector<char> bytes;
+
+public:
+    void putU8(std::uint8_t value);
+    void putU32(std::uint32_t value);
+    void putU64(std::uint64_t value);
+    void putI64(std::int64_t value);
+    void putBytes(const char* data, std::size_t size);
+
+    const char* getData() const;
+    std::size_t getSize() const;
+};
+
+// Bounds-checked cursor over a section payload; any overrun marks the reader as failed
+class ByteReader {
+private:
+    const char* cursor;
+    const char* end;
+    bool ok;
+
+    bool take(void* out, std::size_t size);
+
+public:
+    ByteReader();
+    ByteReader(const char* data, std::size_t size);
+
+    std::uint8_t getU8();
+    std::uint32_t getU32();
+    std::uint64_t getU64();
+    std::int64_t getI64();
+    double getF64();           // Version 1 amounts only
+    std::string_view getBytes(std::size_t size);
+
+    bool good() const;         // False once a read went past the end
+    bool atEnd() const;        // True when the whole payload was consumed
+};
+
+// Deduplicating string table: each distinct string is stored once and referenced by index
+class StringTable {
+private:
+    std::unordered_map<std::string, std::uint32_t> ids;
+    ByteBuffer payload;
+    std::uint32_t count;
+
+public:
+    StringTable();
+
+    std::uint32_t intern(const std::string& value);  // Index of the string, added on first use
+    std::uint32_t add(const std::string& value);     // Appends a string known to be unique, without a lookup
+    void reserve(std::size_t distinct);              // Pre-sizes the deduplication index
+    ByteBuffer encode() const;  // Builds the STRS section payload
+};
+
+// A section ready to be written
+struct SnapshotSection {
+    std::uint32_t tag;
+    ByteBuffer payload;
+};
+
+// Writes the header and all sections in one sequential pass; with sync, forces the file to disk
+bool writeSnapshotFile(const std::string& filename, const std::vector<SnapshotSection>& sections, bool sync = false);
+
+// Writes the snapshot to filename + ".tmp", syncs it and renames it over filename, so a crash
+// leaves either the previous file or the new one whole, never a torn one
+bool replaceSnapshotFile(const std::string& filename, const std::vector<SnapshotSection>& sections);
+// Same for a file of other content: writes the bytes to filename + ".tmp", syncs and renames it
+bool replaceFile(const std::string& filename, const ByteBuffer& contents);
+
+// Reads a snapshot file section by section from a memory mapping, verifying each checksum
+class SnapshotReader {
+private:
+    MappedFile file;
+    ByteReader cursor;
+    std::uint32_t version;
+    std::uint32_t remainingSections;
+    std::string error;
+
+public:
+    SnapshotReader();
+
+    bool open(const std::string& filename);                 // Maps the file and checks the header
+    bool nextSection(std::uint32_t& tag, ByteReader& payload); // False at the end or on a corrupt section
+    std::uint32_t getVersion() const;
+    const std::string& getError() const;                    // Reason of the last failure, empty if none
+};
+
+#endif // SNAPSHOT_H
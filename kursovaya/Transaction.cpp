@@ -1,38 +1,124 @@
 #include "Transaction.h"
+#include <ctime>
+#include <utility>
 
 // Constructor for Transaction: initializes all attributes
-Transaction::Transaction(const std::string& id, const std::string& senderWalletId, const std::string& recipientWalletId,
-                         double amount, TxType type, double commission)
-    : Entity(id), senderWalletId(senderWalletId), recipientWalletId(recipientWalletId),
-      amount(amount), type(type), commission(commission) {}
+Transaction::Transaction(std::string id, std::string senderWalletId, std::string recipientWalletId,
+                         Money amount, TxType type, Money commission, Timestamp timestamp)
+    : Entity(std::move(id)), senderWalletId(std::move(senderWalletId)), recipientWalletId(std::move(recipientWalletId)),
+      amount(amount), type(type), commission(commission),
+      senderHandle(NO_HANDLE), recipientHandle(NO_HANDLE), timestamp(timestamp) {}
 
-// Returns the transaction ID
-std::string Transaction::getId() const {
-    return id;
+// Maps a type to its file code
+char txTypeCode(TxType type) {
+    switch (type) {
+        case TxType::DEBIT:  return 'D';
+        case TxType::CREDIT: return 'C';
+        default:             return 'T';
+    }
+}
+
+// Maps a file code back to its type
+bool txTypeFromCode(char code, TxType& type) {
+    switch (code) {
+        case 'T': type = TxType::TRANSFER; return true;
+        case 'D': type = TxType::DEBIT;    return true;
+        case 'C': type = TxType::CREDIT;   return true;
+    }
+    return false;
+}
+
+// Formats a timestamp in local time, to the second
+std::string formatTimestamp(Timestamp time) {
+    std::time_t seconds = static_cast<std::time_t>(time / 1000);
+    const std::tm* local = std::localtime(&seconds);
+    char text[32];
+    if (!local || std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", local) == 0)
+        return std::to_string(time);
+    return text;
 }
 
 // Returns a formatted string containing all details of the transaction
 std::string Transaction::getDetails() const {
-    return "Transaction " + id + ": from " + senderWalletId + " to " + recipientWalletId +
-           ", amount " + std::to_string(amount) + ", commission " + std::to_string(commission);
+    const char* half = type == TxType::DEBIT ? " (debit half)" : type == TxType::CREDIT ? " (credit half)" : "";
+    return "Transaction " + id + half + ": from " + senderWalletId + " to " + recipientWalletId +
+           ", amount " + formatMoney(amount) + ", commission " + formatMoney(commission) +
+           (timestamp != 0 ? ", at " + formatTimestamp(timestamp) : std::string());
 }
 
 // Returns the transaction amount
-double Transaction::getAmount() const {
+Money Transaction::getAmount() const {
     return amount;
 }
 
 // Returns the transaction commission
-double Transaction::getCommission() const {
+Money Transaction::getCommission() const {
     return commission;
 }
 
 // Returns the sender wallet ID
-std::string Transaction::getSenderWalletId() const {
+const std::string& Transaction::getSenderWalletId() const {
     return senderWalletId;
 }
 
 // Returns the recipient wallet ID
-std::string Transaction::getRecipientWalletId() const {
+const std::string& Transaction::getRecipientWalletId() const {
     return recipientWalletId;
 }
+
+// Returns the sender wallet handle
+IdHandle Transaction::getSenderHandle() const {
+    return senderHandle;
+}
+
+// Returns the recipient wallet handle
+IdHandle Transaction::getRecipientHandle() const {
+    return recipientHandle;
+}
+
+// Records the interned wallet IDs
+void Transaction::setWalletHandles(IdHandle sender, IdHandle recipient) {
+    senderHandle = sender;
+    recipientHandle = recipient;
+}
+
+// Returns the commit time
+Timestamp Transaction::getTimestamp() const {
+    return timestamp;
+}
+
+// Records the commit time
+void Transaction::setTimestamp(Timestamp time) {
+    timestamp = time;
+}
+
+// Returns the type of the transaction
+TxType Transaction::getType() const {
+    return type;
+}
+
+// Changes the type, e.g. to split a transfer into its debit and credit halves
+void Transaction::setType(TxType newType) {
+    type = newType;
+}
+
+// Formats the file line of a transaction; plain transfers keep the six-field format
+std::string formatTransactionRecord(const Transaction& tx) {
+    std::string line = tx.getId() + ";" + tx.getSenderWalletId() + ";" + tx.getRecipientWalletId() + ";" +
+                       formatMoney(tx.getAmount()) + ";" + formatMoney(tx.getCommission()) + ";" +
+                       std::to_string(tx.getTimestamp());
+    if (tx.getType() != TxType::TRANSFER) {
+        line += ';';
+        line += txTypeCode(tx.getType());
+    }
+    return line;
+}
+
+bool isRecordField(std::string_view text) {
+    if (text.empty()) return false;
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (c == ';' || byte < 0x20 || byte == 0x7F) return false;
+    }
+    return true;
+}
@@ -2,42 +2,84 @@
 #define TRANSACTION_H
 
 #include "Entity.h"
+#include "Money.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
 
-// Enumeration for transaction types (currently only TRANSFER supported)
-enum class TxType { TRANSFER };
+// Commit time of a transaction, in milliseconds since the Unix epoch (0 if unknown)
+typedef std::int64_t Timestamp;
+
+// Formats a timestamp as local "YYYY-MM-DD HH:MM:SS"
+std::string formatTimestamp(Timestamp time);
+
+class Transaction;
+
+// Formats the line of a transaction in the ledger files and the write-ahead log:
+// "id;sender;recipient;amount;commission;timestamp", plus ";type" for a debit or credit half
+std::string formatTransactionRecord(const Transaction& tx);
+
+// True if text can be one field of a record: not empty, no ';' and no control characters
+bool isRecordField(std::string_view text);
+
+// Enumeration for transaction types.
+// A transfer between wallets of two ledger shards is stored as two halves, one per shard:
+// the DEBIT on the sender's shard and the CREDIT on the recipient's (see ShardedLedger.h).
+enum class TxType {
+    TRANSFER,   // Both wallets are in this ledger
+    DEBIT,      // Only the sender wallet is in this ledger: withdraws amount + commission
+    CREDIT      // Only the recipient wallet is in this ledger: deposits amount
+};
+
+// One-letter code of a type in the ledger files ('T', 'D' or 'C')
+char txTypeCode(TxType type);
+// Reads a type code; false if the code is unknown
+bool txTypeFromCode(char code, TxType& type);
 
 // Class representing a financial transaction between two wallets
 class Transaction : public Entity {
 private:
     std::string senderWalletId;       // ID of the sender's wallet
     std::string recipientWalletId;    // ID of the recipient's wallet
-    double amount;                    // Amount of money transferred
+    Money amount;                     // Amount of money transferred
     TxType type;                      // Type of transaction
-    double commission;                // Commission charged for the transaction
+    Money commission;                 // Commission charged for the transaction
+    IdHandle senderHandle;            // Interned sender wallet ID (NO_HANDLE until resolved)
+    IdHandle recipientHandle;         // Interned recipient wallet ID (NO_HANDLE until resolved)
+    Timestamp timestamp;              // Commit time, set by the ledger when the transaction commits
 
 public:
     // Constructor to initialize all transaction details
-    Transaction(const std::string& id, const std::string& senderWalletId, const std::string& recipientWalletId,
-                double amount, TxType type, double commission);
-
-    // Returns the transaction ID
-    std::string getId() const override;
+    Transaction(std::string id, std::string senderWalletId, std::string recipientWalletId,
+                Money amount, TxType type, Money commission, Timestamp timestamp = 0);
 
     // Returns a formatted string with transaction details
     std::string getDetails() const;
 
     // Returns the amount transferred
-    double getAmount() const;
+    Money getAmount() const;
 
     // Returns the commission for the transaction
-    double getCommission() const;
+    Money getCommission() const;
 
     // Returns the sender wallet ID
-    std::string getSenderWalletId() const;
+    const std::string& getSenderWalletId() const;
 
     // Returns the recipient wallet ID
-    std::string getRecipientWalletId() const;
+    const std::string& getRecipientWalletId() const;
+
+    // Wallet handles, set by the ledger when it resolves the wallet IDs at intake
+    IdHandle getSenderHandle() const;
+    IdHandle getRecipientHandle() const;
+    void setWalletHandles(IdHandle sender, IdHandle recipient);
+
+    // Returns the type of the transaction
+    TxType getType() const;
+    void setType(TxType type);
+
+    // Returns the commit time (0 until committed, or if it was loaded without one)
+    Timestamp getTimestamp() const;
+    void setTimestamp(Timestamp time);
 };
 
 #endif // TRANSACTION_H
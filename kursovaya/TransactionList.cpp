@@ -1,83 +1,211 @@
 #include "TransactionList.h"
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
 
-// Constructor for a transaction node (doubly linked list node)
-TransactionNode::TransactionNode(Transaction* data)
-    : data(data), prev(nullptr), next(nullptr) {}
+static const std::uint64_t EMPTY_ENTRY = 0;
+static const std::uint64_t DELETED_ENTRY = ~0ULL;
+static const std::size_t NOT_FOUND = static_cast<std::size_t>(-1);
+// Slot + 1 must fit the low 32 bits of an entry
+static const std::uint64_t MAX_SLOTS = 0xFFFFFFFFu;
 
-// Destructor deletes the transaction object
-TransactionNode::~TransactionNode() {
-    delete data;
+static std::uint64_t hashId(std::string_view id) {
+    return std::hash<std::string_view>()(id);
 }
 
-// Constructor initializes an empty transaction list
+// Tag of a hash: its upper 32 bits with the low bit cleared, so no entry is all ones (DELETED_ENTRY)
+static std::uint32_t hashTag(std::uint64_t hash) {
+    return static_cast<std::uint32_t>(hash >> 32) & ~1u;
+}
+
+// Upper 32 bits of an entry: the hash tag compared before touching the stored transaction
+static std::uint32_t entryTag(std::uint64_t entry) {
+    return static_cast<std::uint32_t>(entry >> 32);
+}
+
+// Lower 32 bits of an entry: slot number + 1
+static std::size_t entrySlot(std::uint64_t entry) {
+    return static_cast<std::size_t>(entry & 0xFFFFFFFFu) - 1;
+}
+
+static std::uint64_t makeEntry(std::uint64_t hash, std::size_t position) {
+    return static_cast<std::uint64_t>(hashTag(hash)) << 32 | static_cast<std::uint64_t>(position + 1);
+}
+
+// Constructor initializes an empty store
 TransactionList::TransactionList()
-    : head(nullptr), tail(nullptr), size(0) {}
+    : indexUsed(0), slotCount(0), size(0) {}
 
-// Destructor deletes all nodes in the list
+// Destructor destroys live transactions chunk by chunk and releases the chunks
 TransactionList::~TransactionList() {
-    TransactionNode* current = head;
-    while (current != nullptr) {
-        TransactionNode* nextNode = current->next;
-        delete current;
-        current = nextNode;
+    for (std::size_t i = 0; i < slotCount; ++i) {
+        if (!removed[i])
+            slot(i)->~Transaction();
     }
+    for (Transaction* chunk : chunks)
+        ::operator delete(static_cast<void*>(chunk));
 }
 
-// Adds a transaction to the end of the list
-void TransactionList::addTransaction(Transaction* tx) {
-    TransactionNode* newNode = new TransactionNode(tx);
-    if (!head) {
-        head = tail = newNode;
-    } else {
-        tail->next = newNode;
-        newNode->prev = tail;
-        tail = newNode;
+// Returns the address of a slot
+Transaction* TransactionList::slot(std::size_t position) const {
+    return chunks[position / CHUNK_SIZE] + position % CHUNK_SIZE;
+}
+
+// Allocates enough chunks for count more transactions; throws std::length_error (as a full
+// std::vector would) past the slots an index entry can address
+void TransactionList::reserveSlots(std::size_t count) {
+    if (count > MAX_SLOTS - slotCount)
+        throw std::length_error("TransactionList: more than 2^32 - 1 slots");
+    std::size_t needed = (slotCount + count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    while (chunks.size() < needed)
+        chunks.push_back(static_cast<Transaction*>(::operator new(CHUNK_SIZE * sizeof(Transaction))));
+}
+
+// Rebuilds the index with a power-of-two capacity large enough for count more IDs
+void TransactionList::reserveIndex(std::size_t count) {
+    std::size_t needed = indexUsed + count;
+    if (needed * 10 < index.size() * 7)
+        return;
+
+    std::size_t capacity = 1024;
+    while (capacity * 7 <= (size + count) * 10)
+        capacity *= 2;
+
+    index.assign(capacity, EMPTY_ENTRY);
+    indexUsed = 0;
+    seenIds.reset(capacity * 7 / 10);  // As many keys as the index takes before it grows again
+    for (std::size_t i = 0; i < slotCount; ++i) {
+        if (!removed[i])
+            indexSlot(i);
+    }
+}
+
+// Linear probing: returns the position of the entry holding this ID, or NOT_FOUND
+std::size_t TransactionList::findEntry(std::string_view id, std::uint64_t hash) const {
+    if (index.empty())
+        return NOT_FOUND;
+    std::size_t mask = index.size() - 1;
+    std::uint32_t tag = hashTag(hash);
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+        std::uint64_t entry = index[i];
+        if (entry == EMPTY_ENTRY)
+            return NOT_FOUND;
+        if (entry != DELETED_ENTRY && entryTag(entry) == tag && slot(entrySlot(entry))->getId() == id)
+            return i;
     }
+}
+
+// Points the ID of a slot at that slot, reusing an existing entry for the same ID
+void TransactionList::indexSlot(std::size_t position) {
+    const std::string& id = slot(position)->getId();
+    std::uint64_t hash = hashId(id);
+    std::size_t existing = findEntry(id, hash);
+    if (existing != NOT_FOUND) {
+        index[existing] = makeEntry(hash, position);
+        return;
+    }
+    std::size_t mask = index.size() - 1;
+    std::size_t i = hash & mask;
+    while (index[i] != EMPTY_ENTRY && index[i] != DELETED_ENTRY)
+        i = (i + 1) & mask;
+    if (index[i] == EMPTY_ENTRY)
+        indexUsed++;
+    index[i] = makeEntry(hash, position);
+    seenIds.add(hash);
+}
+
+// Moves a transaction into the next slot and indexes it
+Transaction* TransactionList::addTransaction(Transaction&& tx) {
+    reserveSlots(1);
+    reserveIndex(1);
+    Transaction* stored = new (slot(slotCount)) Transaction(std::move(tx));
+    removed.push_back(0);
+    indexSlot(slotCount);
+    slotCount++;
     size++;
+    return stored;
+}
+
+// Moves a heap-allocated transaction into the store and frees the original
+Transaction* TransactionList::addTransaction(Transaction* tx) {
+    Transaction* stored = addTransaction(std::move(*tx));
+    delete tx;
+    return stored;
 }
 
-// Removes a transaction by its ID from the list
+// Appends a batch after reserving room for all of it at once
+void TransactionList::addTransactions(Transaction* const* txs, std::size_t count) {
+    reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+        addTransaction(txs[i]);
+}
+
+// Grows the chunks, the tombstone flags and the index once for a bulk append
+void TransactionList::reserve(std::size_t count) {
+    reserveSlots(count);
+    reserveIndex(count);
+    removed.reserve(slotCount + count);
+}
+
+// Removes a transaction by its ID, leaving a tombstone in its slot
 bool TransactionList::removeTransaction(const std::string& id) {
-    TransactionNode* current = head;
-    while (current != nullptr) {
-        if (current->data->getId() == id) {
-            // Update links to skip the current node
-            if (current->prev) current->prev->next = current->next;
-            else head = current->next;
-
-            if (current->next) current->next->prev = current->prev;
-            else tail = current->prev;
-
-            delete current;
-            size--;
-            return true;
-        }
-        current = current->next;
-    }
-    return false;
+    std::size_t entry = findEntry(id, hashId(id));
+    if (entry == NOT_FOUND)
+        return false;
+    std::size_t position = entrySlot(index[entry]);
+    index[entry] = DELETED_ENTRY;
+    slot(position)->~Transaction();
+    removed[position] = 1;
+    size--;
+    return true;
 }
 
 // Retrieves a transaction by its ID
 Transaction* TransactionList::getTransaction(const std::string& id) {
-    TransactionNode* current = head;
-    while (current != nullptr) {
-        if (current->data->getId() == id)
-            return current->data;
-        current = current->next;
-    }
-    return nullptr;
+    std::size_t entry = findEntry(id, hashId(id));
+    return entry != NOT_FOUND ? slot(entrySlot(index[entry])) : nullptr;
 }
 
-// Displays all transactions in order from head to tail
+// Checks the Bloom filter first and only probes the index if the ID may be present
+bool TransactionList::contains(std::string_view id) const {
+    std::uint64_t hash = hashId(id);
+    return seenIds.mayContain(hash) && findEntry(id, hash) != NOT_FOUND;
+}
+
+// Displays all transactions in append order
 void TransactionList::displayTransactions() const {
-    TransactionNode* current = head;
-    while (current) {
-        std::cout << current->data->getDetails() << std::endl;
-        current = current->next;
-    }
+    forEach([](const Transaction& tx) {
+        std::cout << tx.getDetails() << std::endl;
+    });
+}
+
+// Returns the number of transactions in the store
+std::size_t TransactionList::getSize() const {
+    return size;
+}
+
+// Returns the number of slots used so far
+std::size_t TransactionList::getSlotCount() const {
+    return slotCount;
+}
+
+// Returns the transaction stored in a slot, or nullptr if it was removed
+const Transaction* TransactionList::getAt(std::size_t position) const {
+    if (position >= slotCount || removed[position])
+        return nullptr;
+    return slot(position);
 }
 
-// Returns the head pointer of the list
-TransactionNode* TransactionList::getHead() const {
-    return head;
+// Visits every live transaction in append order, one chunk at a time
+void TransactionList::forEach(const std::function<void(const Transaction&)>& visit) const {
+    for (std::size_t c = 0; c < chunks.size(); ++c) {
+        std::size_t first = c * CHUNK_SIZE;
+        std::size_t last = std::min(first + CHUNK_SIZE, slotCount);
+        for (std::size_t i = first; i < last; ++i) {
+            if (!removed[i])
+                visit(chunks[c][i - first]);
+        }
+    }
 }
@@ -1,37 +1,65 @@
 #ifndef TRANSACTIONLIST_H
 #define TRANSACTIONLIST_H
 
+#include "BloomFilter.h"
 #include "Transaction.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
 
-// Node class for doubly linked list, stores a pointer to a Transaction
-class TransactionNode {
-public:
-    Transaction* data;          // Pointer to the transaction data
-    TransactionNode* prev;      // Pointer to previous node
-    TransactionNode* next;      // Pointer to next node
-
-    TransactionNode(Transaction* data); // Constructor
-    ~TransactionNode();                  // Destructor
-};
-
-// Class implementing a doubly linked list of transactions
+// Append-ordered store of transactions.
+// Transactions live by value in fixed-size chunks, so appending never moves stored objects
+// (pointers stay valid) and iteration is a linear scan over contiguous memory.
+// An open-addressing hash index on the transaction ID makes lookup and removal O(1).
+// Index entries are 8 bytes (a hash tag and the slot number) and keys are compared against
+// the stored transactions, so the index allocates nothing per transaction. Removal leaves a
+// tombstone so the slot numbers of the remaining transactions never change. An entry has 32 bits
+// for the slot, so the store holds at most 2^32 - 1 slots; appending past that throws std::length_error.
+// A Bloom filter sized with the index sits in front of it for contains(): most IDs that are not
+// in the store are rejected from one cache line, without probing the index.
 class TransactionList {
 private:
-    TransactionNode* head;  // Pointer to the head of the list
-    TransactionNode* tail;  // Pointer to the tail of the list
-    int size;               // Number of transactions in the list
+    static const std::size_t CHUNK_SIZE = 4096;  // Transactions per chunk
+
+    std::vector<Transaction*> chunks;            // Raw storage, CHUNK_SIZE objects each
+    std::vector<std::uint8_t> removed;           // Tombstone flag per slot
+    std::vector<std::uint64_t> index;            // Open-addressing table: (hash tag << 32) | (slot + 1);
+                                                 // the tag's low bit is 0, so no entry equals the deleted marker
+    std::size_t indexUsed;                       // Index entries in use, including deleted markers
+    std::size_t slotCount;                       // Slots used, including removed ones
+    std::size_t size;                            // Number of live transactions
+    BloomFilter seenIds;                         // Every indexed ID (rebuilt with the index)
+
+    Transaction* slot(std::size_t position) const;  // Address of a slot
+    void reserveSlots(std::size_t count);           // Makes room for count more appends (at most 2^32 - 1 slots)
+    void reserveIndex(std::size_t count);           // Grows the index so count more IDs keep it under 70% full
+    std::size_t findEntry(std::string_view id, std::uint64_t hash) const; // Index entry of an ID, or npos
+    void indexSlot(std::size_t position);           // Adds (or repoints) the entry for a slot's ID
 
 public:
-    TransactionList();      // Constructor initializes empty list
-    ~TransactionList();     // Destructor cleans up all nodes
+    TransactionList();      // Constructor initializes an empty store
+    ~TransactionList();     // Destructor destroys the stored transactions and frees the chunks
+
+    TransactionList(const TransactionList&) = delete;
+    TransactionList& operator=(const TransactionList&) = delete;
 
-    void addTransaction(Transaction* tx);        // Adds a transaction to the list
-    bool removeTransaction(const std::string& id); // Removes a transaction by ID
+    Transaction* addTransaction(Transaction* tx);   // Moves a heap transaction into the store and deletes it
+    Transaction* addTransaction(Transaction&& tx);  // Moves a transaction into the store
+    void addTransactions(Transaction* const* txs, std::size_t count); // Batch version of addTransaction(Transaction*)
+    void reserve(std::size_t count);                // Makes room for count more transactions up front
+    bool removeTransaction(const std::string& id);  // Removes a transaction by ID
     Transaction* getTransaction(const std::string& id); // Retrieves a transaction by ID
-    void displayTransactions() const;             // Prints all transactions
+    bool contains(std::string_view id) const;       // True if a live transaction has this ID
+    void displayTransactions() const;               // Prints all transactions
 
-    TransactionNode* getHead() const;              // Returns pointer to head node
+    std::size_t getSize() const;                    // Number of live transactions
+    std::size_t getSlotCount() const;               // Number of slots used, including removed ones
+    const Transaction* getAt(std::size_t position) const; // Transaction in a slot, nullptr if removed
+    void forEach(const std::function<void(const Transaction&)>& visit) const; // Visits in append order
 };
 
 #endif // TRANSACTIONLIST_H
@@ -0,0 +1,105 @@
+#include "TransactionLog.h"
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Constructor creates a closed log
+TransactionLog::TransactionLog() : file(nullptr) {}
+
+// Destructor flushes and closes the log
+TransactionLog::~TransactionLog() {
+    close();
+}
+
+// Returns the size of the file up to and including its last complete line
+static std::uintmax_t completeLength(const std::string& filename) {
+    FILE* in = fopen(filename.c_str(), "rb");
+    if (!in) return 0;
+    std::uintmax_t length = 0, position = 0;
+    char buffer[65536];
+    std::size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (buffer[i] == '\n') length = position + i + 1;
+        }
+        position += n;
+    }
+    fclose(in);
+    return length;
+}
+
+// Opens the log for appending after cutting off a torn final record
+bool TransactionLog::open(const std::string& name) {
+    close();
+    filename = name;
+
+    std::error_code ec;
+    if (std::filesystem::exists(filename, ec)) {
+        std::uintmax_t length = completeLength(filename);
+        if (length != std::filesystem::file_size(filename, ec))
+            std::filesystem::resize_file(filename, length, ec);
+        if (ec) return false;
+    }
+
+    file = fopen(filename.c_str(), "ab");
+    return file != nullptr;
+}
+
+// Flushes pending records and closes the file
+void TransactionLog::close() {
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+bool TransactionLog::isOpen() const {
+    return file != nullptr;
+}
+
+// Buffers one committed transaction record
+bool TransactionLog::append(const Transaction& tx) {
+    if (!file) return false;
+    return fprintf(file, "%s\n", formatTransactionRecord(tx).c_str()) > 0;
+}
+
+// Buffers one line as given (without its line ending)
+bool TransactionLog::appendRecord(const std::string& record) {
+    if (!file) return false;
+    return fprintf(file, "%s\n", record.c_str()) > 0;
+}
+
+// Buffers already formatted lines as they are
+bool TransactionLog::appendLines(const std::string& lines) {
+    if (!file) return false;
+    return fwrite(lines.data(), 1, lines.size(), file) == lines.size();
+}
+
+// Hands buffered records to the OS, so they survive a crash of the process
+bool TransactionLog::flush() {
+    return file && fflush(file) == 0;
+}
+
+// Flushes and forces the log to stable storage, so it also survives a crash of the machine
+bool TransactionLog::sync() {
+    if (!flush()) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Truncates the log; used after a full save made its records redundant
+bool TransactionLog::reset() {
+    if (!file) return false;
+    fclose(file);
+    file = fopen(filename.c_str(), "wb");
+    return file != nullptr;
+}
@@ -0,0 +1,39 @@
+#ifndef TRANSACTIONLOG_H
+#define TRANSACTIONLOG_H
+
+#include "Transaction.h"
+#include <cstdio>
+#include <string>
+
+// Append-only write-ahead log of committed transactions.
+// Records use the same "id;sender;recipient;amount;commission;timestamp[;type]" line format as
+// the transaction file (see formatTransactionRecord), so the log can be replayed with the
+// regular ledger parser.
+// Appends are buffered; flush() hands them to the OS and sync() forces them to disk.
+class TransactionLog {
+private:
+    FILE* file;              // Log opened in append mode (nullptr when closed)
+    std::string filename;    // Path of the log file
+
+public:
+    TransactionLog();
+    ~TransactionLog();
+
+    TransactionLog(const TransactionLog&) = delete;
+    TransactionLog& operator=(const TransactionLog&) = delete;
+
+    // Opens (or creates) the log for appending. A record torn by a crash is cut off first,
+    // so new records never get glued to a partial line.
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const;
+
+    bool append(const Transaction& tx);   // Buffers one committed transaction
+    bool appendRecord(const std::string& record); // Buffers a raw line, for logs with their own record kinds
+    bool appendLines(const std::string& lines);   // Buffers complete lines ("...\n" each) in one write
+    bool flush();                         // Writes buffered records to the OS
+    bool sync();                          // Flushes and forces the log to stable storage
+    bool reset();                         // Empties the log once its records are saved elsewhere
+};
+
+#endif // TRANSACTIONLOG_H
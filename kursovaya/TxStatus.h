@@ -0,0 +1,25 @@
+#ifndef TXSTATUS_H
+#define TXSTATUS_H
+
+#include <cstddef>
+
+// Outcome of validating and applying a single transaction
+enum class TxStatus {
+    OK,
+    WALLET_NOT_FOUND,     // Sender or recipient wallet is not indexed
+    CLIENT_NOT_FOUND,     // No client owns the sender wallet
+    LIMIT_EXCEEDED,       // Amount is above the sender's transaction limit
+    INSUFFICIENT_FUNDS,   // Sender wallet cannot cover amount + commission
+    WITHDRAW_FAILED,      // Wallet refused the withdrawal
+    DUPLICATE_ID,         // A transaction with this ID was already committed
+    LOG_FAILED,           // The transfer could not be logged, so it was not started
+    INVALID_AMOUNT        // Amount is not positive or commission is negative
+};
+
+// Number of TxStatus values (keep in sync with the enum)
+const std::size_t TX_STATUS_COUNT = 9;
+
+// Returns a human-readable description of a transaction status
+const char* txStatusMessage(TxStatus status);
+
+#endif // TXSTATUS_H
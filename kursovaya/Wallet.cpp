@@ -1,35 +1,45 @@
 #include "Wallet.h"
+#include "Client.h"
 
 // Constructor initializes wallet with ID, owner ID, and initial balance
-Wallet::Wallet(const std::string& id, const std::string& ownerId, double balance)
-    : Entity(id), ownerId(ownerId), balance(balance) {}
+Wallet::Wallet(const std::string& id, const std::string& ownerId, Money balance)
+    : id(&id), handle(NO_HANDLE), balance(balance), ownerId(&ownerId), owner(nullptr), nextOfOwner(nullptr) {}
 
 // Adds the specified amount to the wallet balance if positive
-void Wallet::deposit(double amount) {
-    if (amount > 0) balance += amount;
+void Wallet::deposit(Money amount) {
+    if (amount > 0) {
+        balance += amount;
+        if (owner) owner->adjustTotalBalance(amount);
+    }
 }
 
 // Withdraws the specified amount if it is positive and sufficient balance exists
 // Returns true if successful, false otherwise
-bool Wallet::withdraw(double amount) {
+bool Wallet::withdraw(Money amount) {
     if (amount > 0 && amount <= balance) {
         balance -= amount;
+        if (owner) owner->adjustTotalBalance(-amount);
         return true;
     }
     return false;
 }
 
 // Returns the current balance in the wallet
-double Wallet::getBalance() const {
+Money Wallet::getBalance() const {
     return balance;
 }
 
-// Returns the wallet ID
-std::string Wallet::getId() const {
-    return id;
+// Returns the ID of the wallet owner (client)
+const std::string& Wallet::getOwnerId() const {
+    return *ownerId;
 }
 
-// Returns the ID of the wallet owner (client)
-std::string Wallet::getOwnerId() const {
-    return ownerId;
+// Returns the client listing this wallet
+Client* Wallet::getOwner() const {
+    return owner;
+}
+
+// Records the client listing this wallet
+void Wallet::setOwner(Client* client) {
+    owner = client;
 }
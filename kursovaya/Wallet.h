@@ -1,34 +1,51 @@
 #ifndef WALLET_H
 #define WALLET_H
 
-#include "Entity.h"
+#include "IdTable.h"
+#include "Money.h"
 #include <string>
 
-// Class representing a Wallet, which stores funds and belongs to a client
-class Wallet : public Entity {
+class Client;
+
+// Class representing a Wallet, which stores funds and belongs to a client.
+// Wallets live in the ledger's wallet pool; like clients they own no strings (the IDs are
+// entries of the ledger's interning tables), so the pool releases them slab by slab.
+class Wallet {
 private:
-    double balance;          // Current balance in the wallet
-    std::string ownerId;     // ID of the wallet's owner (client)
+    const std::string* id;   // Interned wallet ID
+    IdHandle handle;         // Handle of the ID in the ledger's wallet table
+    Money balance;           // Current balance in the wallet
+    const std::string* ownerId; // Interned ID of the wallet's owner (client)
+    Client* owner;           // Client whose cached total follows this balance (set by Client::addWallet)
+    Wallet* nextOfOwner;     // Next wallet of the same client (see Client::getFirstWallet)
 
 public:
-    // Constructor to initialize wallet ID, owner ID, and starting balance
-    Wallet(const std::string& id, const std::string& ownerId, double balance);
+    // Constructor to initialize wallet ID, owner ID, and starting balance; the IDs must outlive the wallet
+    Wallet(const std::string& id, const std::string& ownerId, Money balance);
+
+    const std::string& getId() const { return *id; }
+    IdHandle getHandle() const { return handle; }
+    void setHandle(IdHandle value) { handle = value; }
 
-    // Deposits the specified amount into the wallet
-    void deposit(double amount);
+    // Deposits the specified amount into the wallet (and into the owner's total)
+    void deposit(Money amount);
 
-    // Withdraws the specified amount from the wallet if possible
+    // Withdraws the specified amount from the wallet (and from the owner's total) if possible
     // Returns true if successful, false otherwise
-    bool withdraw(double amount);
+    bool withdraw(Money amount);
 
     // Returns the current wallet balance
-    double getBalance() const;
-
-    // Returns the wallet ID (overrides Entity's pure virtual method)
-    std::string getId() const override;
+    Money getBalance() const;
 
     // Returns the owner (client) ID
-    std::string getOwnerId() const;
+    const std::string& getOwnerId() const;
+
+    // Client listing this wallet, nullptr if none
+    Client* getOwner() const;
+    void setOwner(Client* client);
+
+    Wallet* getNextOfOwner() const { return nextOfOwner; }
+    void setNextOfOwner(Wallet* wallet) { nextOfOwner = wallet; }
 };
 
 #endif // WALLET_H
@@ -0,0 +1,82 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+
+// Starts the worker threads; they sleep until a job is posted
+WorkerPool::WorkerPool(std::size_t threadCount)
+    : job(nullptr), generation(0), running(0), stopping(false) {
+    threadCount = std::max<std::size_t>(threadCount, 1);
+    for (std::size_t i = 0; i < threadCount; ++i)
+        threads.emplace_back(&WorkerPool::workerLoop, this, i);
+}
+
+// Wakes every worker with the stop flag set and joins them
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : threads)
+        t.join();
+}
+
+// Waits for a new generation, runs the job, and reports back when it is the last one done
+void WorkerPool::workerLoop(std::size_t worker) {
+    std::size_t seen = 0;
+    while (true) {
+        const std::function<void(std::size_t)>* current;
+        {
+            std::unique_lock<std::mutex> guard(mutex);
+            wake.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            current = job;
+        }
+
+        (*current)(worker);
+
+        std::lock_guard<std::mutex> guard(mutex);
+        if (--running == 0)
+            done.notify_one();
+    }
+}
+
+std::size_t WorkerPool::getThreadCount() const {
+    return threads.size();
+}
+
+// Publishes the job to all workers and blocks until they have all run it
+void WorkerPool::run(const std::function<void(std::size_t)>& work, std::size_t participants) {
+    if (participants != 0 && participants < threads.size()) {
+        // The other workers wake up and return at once
+        std::function<void(std::size_t)> capped = [&](std::size_t worker) {
+            if (worker < participants) work(worker);
+        };
+        run(capped);
+        return;
+    }
+    std::unique_lock<std::mutex> guard(mutex);
+    job = &work;
+    running = threads.size();
+    ++generation;
+    wake.notify_all();
+    done.wait(guard, [&] { return running == 0; });
+    job = nullptr;
+}
+
+// Workers repeatedly claim the next chunk from a shared counter until the range is exhausted
+void WorkerPool::parallelFor(std::size_t count, std::size_t chunkSize,
+                             const std::function<void(std::size_t, std::size_t, std::size_t)>& body,
+                             std::size_t participants) {
+    if (count == 0) return;
+    chunkSize = std::max<std::size_t>(chunkSize, 1);
+    std::atomic<std::size_t> next(0);
+    run([&](std::size_t worker) {
+        while (true) {
+            std::size_t begin = next.fetch_add(chunkSize);
+            if (begin >= count) return;
+            body(begin, std::min(begin + chunkSize, count), worker);
+        }
+    }, participants);
+}
@@ -0,0 +1,45 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run one job at a time.
+// The caller blocks until every worker has finished the current job.
+class WorkerPool {
+private:
+    std::vector<std::thread> threads;                  // Worker threads
+    std::mutex mutex;                                  // Guards the fields below
+    std::condition_variable wake;                      // Signals a new job (or shutdown) to the workers
+    std::condition_variable done;                      // Signals the caller that all workers finished
+    const std::function<void(std::size_t)>* job;       // Current job, called with the worker number
+    std::size_t generation;                            // Incremented for every job
+    std::size_t running;                               // Workers still busy with the current job
+    bool stopping;                                     // Set by the destructor
+
+    void workerLoop(std::size_t worker);
+
+public:
+    explicit WorkerPool(std::size_t threadCount);      // Starts threadCount workers (at least one)
+    ~WorkerPool();                                     // Stops and joins the workers
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    std::size_t getThreadCount() const;
+
+    // Runs job(worker) once on each of the first participants workers (0 = all) and waits for them
+    void run(const std::function<void(std::size_t)>& job, std::size_t participants = 0);
+
+    // Splits [0, count) into chunks handed out dynamically to the workers (the first participants
+    // of them, 0 = all) and waits. body(begin, end, worker) processes one chunk.
+    void parallelFor(std::size_t count, std::size_t chunkSize,
+                     const std::function<void(std::size_t, std::size_t, std::size_t)>& body,
+                     std::size_t participants = 0);
+};
+
+#endif // WORKERPOOL_H
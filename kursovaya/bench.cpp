@@ -0,0 +1,335 @@
+// Ledger benchmark: generates a synthetic book of clients, wallets and transfers, then times the
+// hot paths of Blockchain and ClientBST and the save/load paths.
+//
+// Usage: bench [--clients N] [--wallets K] [--tiers S:G:P] [--dist uniform|zipf] [--zipf S]
+//              [--transfers N] [--lookups N] [--threads N] [--seed N]
+//
+// Per-operation benchmarks report mean ns/op and the p50/p99/max latencies of single calls;
+// bulk benchmarks (save/load) report their total time and ns per record. The parallel sweep
+// runs the same transfer batches through processTransactions and through
+// processTransactionsParallel with 1, 2, 4, ... up to --threads workers, from the same state.
+#include "Blockchain.h"
+#include "ClientBST.h"
+#include "Money.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Workload parameters
+struct BenchConfig {
+    std::size_t clients = 100000;
+    std::size_t walletsPerClient = 4;
+    unsigned tierWeights[TIER_COUNT] = {60, 30, 10};  // Standard:Gold:Platinum
+    bool zipf = false;                                // Hot-wallet distribution instead of uniform
+    double zipfExponent = 1.1;
+    std::size_t transfers = 200000;
+    std::size_t lookups = 200000;
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());  // Largest worker count of the sweep
+    unsigned seed = 42;
+};
+
+// Picks wallet indexes uniformly or with Zipf-distributed popularity (rank 1 is the hottest)
+class WalletPicker {
+private:
+    std::size_t count;
+    std::vector<double> cdf;                         // Cumulative Zipf weights (empty when uniform)
+    std::vector<std::uint32_t> rankToWallet;         // Hot ranks spread over the book, not the first clients
+    std::uniform_int_distribution<std::size_t> uniform;
+    std::uniform_real_distribution<double> unit;
+
+public:
+    WalletPicker(std::size_t count, bool zipf, double exponent, std::mt19937_64& rng)
+        : count(count), uniform(0, count - 1), unit(0.0, 1.0) {
+        if (!zipf) return;
+        cdf.resize(count);
+        double sum = 0;
+        for (std::size_t rank = 0; rank < count; ++rank) {
+            sum += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+            cdf[rank] = sum;
+        }
+        for (double& value : cdf) value /= sum;
+        rankToWallet.resize(count);
+        for (std::size_t i = 0; i < count; ++i) rankToWallet[i] = static_cast<std::uint32_t>(i);
+        std::shuffle(rankToWallet.begin(), rankToWallet.end(), rng);
+    }
+
+    std::size_t pick(std::mt19937_64& rng) {
+        if (cdf.empty()) return uniform(rng);
+        std::size_t rank = std::lower_bound(cdf.begin(), cdf.end(), unit(rng)) - cdf.begin();
+        return rankToWallet[std::min(rank, count - 1)];
+    }
+};
+
+// Latency samples of one benchmark
+class Samples {
+private:
+    std::vector<std::uint64_t> ns;
+
+public:
+    explicit Samples(std::size_t reserve) { ns.reserve(reserve); }
+
+    void add(Clock::time_point start, Clock::time_point end) {
+        ns.push_back(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    }
+
+    // Prints "name  ops  mean  p50  p99  max"
+    void report(const char* name) {
+        if (ns.empty()) return;
+        double total = 0;
+        for (std::uint64_t value : ns) total += static_cast<double>(value);
+        std::sort(ns.begin(), ns.end());
+        auto percentile = [&](double p) { return ns[static_cast<std::size_t>(p * (ns.size() - 1))]; };
+        std::printf("%-28s %10zu %10.0f %10llu %10llu %10llu\n", name, ns.size(), total / ns.size(),
+                    static_cast<unsigned long long>(percentile(0.50)),
+                    static_cast<unsigned long long>(percentile(0.99)),
+                    static_cast<unsigned long long>(ns.back()));
+    }
+};
+
+// Prints a bulk benchmark line: total time and ns per record
+static void reportBulk(const char* name, std::size_t records, Clock::time_point start) {
+    double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    std::printf("%-28s %10zu %10.0f %21s total %.1f ms\n", name, records, records ? ns / records : 0.0, "", ns / 1e6);
+}
+
+static std::string clientId(std::size_t i) { return "c" + std::to_string(i); }
+static std::string walletId(std::size_t i) { return "w" + std::to_string(i); }
+
+// Parses the command line; false (after printing the usage) on anything unknown
+static bool parseArgs(int argc, char* argv[], BenchConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool ok = value != nullptr;
+        if (arg == "--clients" && ok) config.clients = std::strtoull(value, nullptr, 10);
+        else if (arg == "--wallets" && ok) config.walletsPerClient = std::strtoull(value, nullptr, 10);
+        else if (arg == "--tiers" && ok)
+            ok = std::sscanf(value, "%u:%u:%u", &config.tierWeights[0], &config.tierWeights[1], &config.tierWeights[2]) == 3;
+        else if (arg == "--dist" && ok) {
+            config.zipf = std::strcmp(value, "zipf") == 0;
+            ok = config.zipf || std::strcmp(value, "uniform") == 0;
+        }
+        else if (arg == "--zipf" && ok) config.zipfExponent = std::strtod(value, nullptr);
+        else if (arg == "--transfers" && ok) config.transfers = std::strtoull(value, nullptr, 10);
+        else if (arg == "--lookups" && ok) config.lookups = std::strtoull(value, nullptr, 10);
+        else if (arg == "--threads" && ok) config.threads = std::strtoull(value, nullptr, 10);
+        else if (arg == "--seed" && ok) config.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else ok = false;
+
+        if (!ok || config.clients == 0 || config.walletsPerClient == 0 || config.threads == 0) {
+            std::fprintf(stderr, "Usage: %s [--clients N] [--wallets K] [--tiers S:G:P] [--dist uniform|zipf] "
+                                 "[--zipf S] [--transfers N] [--lookups N] [--threads N] [--seed N]\n", argv[0]);
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    if (!parseArgs(argc, argv, config))
+        return 2;
+
+    std::mt19937_64 rng(config.seed);
+    const std::size_t walletCount = config.clients * config.walletsPerClient;
+    std::discrete_distribution<int> tierDist(std::begin(config.tierWeights), std::end(config.tierWeights));
+    std::uniform_int_distribution<Money> balanceDist(money(100), money(100000));
+
+    std::printf("clients=%zu wallets=%zu tiers=%u:%u:%u dist=%s transfers=%zu lookups=%zu seed=%u\n\n",
+                config.clients, walletCount, config.tierWeights[0], config.tierWeights[1], config.tierWeights[2],
+                config.zipf ? "zipf" : "uniform", config.transfers, config.lookups, config.seed);
+    std::printf("%-28s %10s %10s %10s %10s %10s\n", "benchmark", "ops", "ns/op", "p50", "p99", "max");
+
+    // ClientBST on its own: insert clients with random totals, then find them by handle
+    {
+        IdTable ids;
+        const std::string name = "bench";
+        ObjectPool<Client> pool;
+        std::vector<Client*> pending(config.clients);
+        for (std::size_t i = 0; i < config.clients; ++i) {
+            IdHandle handle = ids.intern(clientId(i));
+            pending[i] = pool.create(ids.name(handle), name, static_cast<ClientTier>(tierDist(rng)));
+            pending[i]->setHandle(handle);
+            pending[i]->adjustTotalBalance(balanceDist(rng));
+        }
+        ClientBST tree;
+        Samples inserts(config.clients);
+        for (Client* client : pending) {
+            auto start = Clock::now();
+            tree.insert(client);
+            inserts.add(start, Clock::now());
+        }
+        inserts.report("ClientBST::insert");
+
+        std::uniform_int_distribution<IdHandle> handleDist(0, static_cast<IdHandle>(config.clients - 1));
+        Samples finds(config.lookups);
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < config.lookups; ++i) {
+            IdHandle handle = handleDist(rng);
+            auto start = Clock::now();
+            found += tree.find(handle) != nullptr;
+            finds.add(start, Clock::now());
+        }
+        finds.report("ClientBST::find");
+        if (found != config.lookups) std::printf("  (missed %zu lookups)\n", config.lookups - found);
+    }
+
+    // Ledger: clients, wallets, then the transfer workload
+    Blockchain ledger;
+    std::vector<ClientTier> walletTier(walletCount);
+    auto buildStart = Clock::now();
+    for (std::size_t c = 0; c < config.clients; ++c) {
+        Client* client = ledger.addClient(clientId(c), "bench", static_cast<ClientTier>(tierDist(rng)));
+        for (std::size_t k = 0; k < config.walletsPerClient; ++k) {
+            std::size_t w = c * config.walletsPerClient + k;
+            walletTier[w] = client->getTier();
+            ledger.createWallet(client, walletId(w), balanceDist(rng));
+        }
+    }
+    reportBulk("ledger build (per wallet)", walletCount, buildStart);
+
+    WalletPicker picker(walletCount, config.zipf, config.zipfExponent, rng);
+    {
+        std::vector<std::string> ids(config.lookups);
+        for (std::string& id : ids) id = walletId(picker.pick(rng));
+        Samples lookups(config.lookups);
+        std::size_t found = 0;
+        for (const std::string& id : ids) {
+            auto start = Clock::now();
+            found += ledger.findWalletById(id) != nullptr;
+            lookups.add(start, Clock::now());
+        }
+        lookups.report("findWalletById");
+    }
+
+    {
+        // Amounts stay under the smallest tier limit, so rejections come from funds only
+        std::uniform_int_distribution<Money> amountDist(1, tierPolicy(ClientTier::STANDARD).maxTransaction / 2);
+        std::vector<Transaction> transfers;
+        transfers.reserve(config.transfers);
+        for (std::size_t i = 0; i < config.transfers; ++i) {
+            std::size_t sender = picker.pick(rng);
+            std::size_t recipient = picker.pick(rng);
+            Money amount = amountDist(rng);
+            Money commission = applyRate(amount, tierPolicy(walletTier[sender]).commissionBps);
+            transfers.emplace_back("t" + std::to_string(i), walletId(sender), walletId(recipient), amount,
+                                   TxType::TRANSFER, commission);
+        }
+
+        Samples commits(config.transfers);
+        std::size_t accepted = 0;
+        for (Transaction& tx : transfers) {
+            auto start = Clock::now();
+            accepted += ledger.processTransaction(std::move(tx)) == TxStatus::OK;
+            commits.add(start, Clock::now());
+        }
+        commits.report("processTransaction");
+        std::printf("  (%zu accepted, %zu rejected)\n", accepted, config.transfers - accepted);
+    }
+
+    // Save/load paths, through temporary files in the current directory
+    const std::size_t transactionCount = config.transfers;
+    const char* clientsFile = "bench_clients.txt";
+    const char* transactionsFile = "bench_transactions.txt";
+    const char* snapshotFile = "bench.snapshot";
+
+    auto start = Clock::now();
+    ledger.saveClientsToFile(clientsFile);
+    reportBulk("saveClientsToFile (wallet)", walletCount, start);
+    start = Clock::now();
+    ledger.saveTransactionsToFile(transactionsFile);
+    reportBulk("saveTransactionsToFile (tx)", transactionCount, start);
+    start = Clock::now();
+    ledger.saveSnapshot(snapshotFile);
+    reportBulk("saveSnapshot (wallet+tx)", walletCount + transactionCount, start);
+    {
+        Blockchain loaded;
+        start = Clock::now();
+        loaded.loadClientsFromFile(clientsFile);
+        reportBulk("loadClientsFromFile (wallet)", walletCount, start);
+        start = Clock::now();
+        loaded.loadTransactionsFromFile(transactionsFile);
+        reportBulk("loadTransactionsFromFile (tx)", transactionCount, start);
+    }
+    {
+        std::unique_ptr<Blockchain> loaded(new Blockchain());
+        start = Clock::now();
+        loaded->loadSnapshot(snapshotFile);
+        reportBulk("loadSnapshot (wallet+tx)", walletCount + transactionCount, start);
+        // Clients and wallets go with their slabs; the ID tables and the transactions' strings are freed one by one
+        start = Clock::now();
+        loaded.reset();
+        reportBulk("teardown (wallet+tx)", walletCount + transactionCount, start);
+    }
+
+    // Batch commit sweep: every run starts from the saved clients file and commits the same batches
+    {
+        std::uniform_int_distribution<Money> amountDist(1, tierPolicy(ClientTier::STANDARD).maxTransaction / 2);
+        std::vector<Transaction> batchTransfers;
+        batchTransfers.reserve(config.transfers);
+        for (std::size_t i = 0; i < config.transfers; ++i) {
+            std::size_t sender = picker.pick(rng);
+            std::size_t recipient = picker.pick(rng);
+            Money amount = amountDist(rng);
+            batchTransfers.emplace_back("p" + std::to_string(i), walletId(sender), walletId(recipient), amount,
+                                        TxType::TRANSFER, applyRate(amount, tierPolicy(walletTier[sender]).commissionBps));
+        }
+
+        const std::size_t batchSize = 4096;
+        std::vector<TxStatus> serialStatuses;
+        double serialNs = 0;
+        auto runBatches = [&](std::size_t threads, std::vector<TxStatus>& statuses) {
+            Blockchain fresh;
+            fresh.loadClientsFromFile(clientsFile);
+            std::vector<Transaction*> batch(batchTransfers.size());
+            for (std::size_t i = 0; i < batch.size(); ++i)
+                batch[i] = new Transaction(batchTransfers[i]);
+            statuses.clear();
+            auto runStart = Clock::now();
+            for (std::size_t offset = 0; offset < batch.size(); offset += batchSize) {
+                std::size_t n = std::min(batchSize, batch.size() - offset);
+                std::vector<TxStatus> part = threads == 0
+                    ? fresh.processTransactions(batch.data() + offset, n)
+                    : fresh.processTransactionsParallel(batch.data() + offset, n, threads);
+                statuses.insert(statuses.end(), part.begin(), part.end());
+            }
+            double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - runStart).count());
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                if (statuses[i] != TxStatus::OK) delete batch[i];
+            }
+            return ns;
+        };
+
+        std::printf("\n%-28s %10s %10s %10s %10s\n", "batch commit (4096/batch)", "threads", "ns/tx", "tx/s", "speedup");
+        serialNs = runBatches(0, serialStatuses);
+        std::size_t count = batchTransfers.size();
+        std::printf("%-28s %10s %10.0f %10.0f %10s\n", "processTransactions", "-", serialNs / count,
+                    count / (serialNs / 1e9), "1.00");
+        for (std::size_t threads = 1;; threads = std::min(threads * 2, config.threads)) {
+            std::vector<TxStatus> statuses;
+            double ns = runBatches(threads, statuses);
+            std::size_t differing = 0;
+            for (std::size_t i = 0; i < count; ++i) differing += statuses[i] != serialStatuses[i];
+            std::printf("%-28s %10zu %10.0f %10.0f %10.2f\n", "processTransactionsParallel", threads, ns / count,
+                        count / (ns / 1e9), serialNs / ns);
+            if (differing) std::printf("  (%zu statuses differ from processTransactions)\n", differing);
+            if (threads == config.threads) break;
+        }
+    }
+
+    std::remove(clientsFile);
+    std::remove(transactionsFile);
+    std::remove(snapshotFile);
+    return 0;
+}
@@ -3,9 +3,11 @@ REM Clean old object files and executable
 del *.o 2>nul
 del *.obj 2>nul
 del main.exe 2>nul
+del bench.exe 2>nul
+del tests.exe 2>nul
 
 REM Compile all .cpp files together
-g++ main.cpp Client.cpp Wallet.cpp Blockchain.cpp Transaction.cpp TransactionList.cpp ClientBST.cpp EntityVector.cpp -o main.exe
+g++ -std=c++17 -pthread main.cpp Client.cpp Wallet.cpp Blockchain.cpp Transaction.cpp TransactionList.cpp ClientBST.cpp MappedFile.cpp LedgerParser.cpp Snapshot.cpp TransactionLog.cpp WorkerPool.cpp Money.cpp Sha256.cpp Block.cpp IdTable.cpp LedgerMetrics.cpp RangeIndex.cpp BloomFilter.cpp IdArchive.cpp ShardedLedger.cpp LedgerServer.cpp GroupCommitLog.cpp CheckpointManager.cpp -o main.exe
 
 REM Check if compilation succeeded
 if errorlevel 1 (
@@ -14,6 +16,26 @@ if errorlevel 1 (
     exit /b 1
 )
 
+REM Compile the benchmark (optimized; run bench.exe --help for its options)
+g++ -std=c++17 -O2 -pthread bench.cpp Client.cpp Wallet.cpp Blockchain.cpp Transaction.cpp TransactionList.cpp ClientBST.cpp MappedFile.cpp LedgerParser.cpp Snapshot.cpp TransactionLog.cpp WorkerPool.cpp Money.cpp Sha256.cpp Block.cpp IdTable.cpp LedgerMetrics.cpp RangeIndex.cpp BloomFilter.cpp IdArchive.cpp ShardedLedger.cpp LedgerServer.cpp GroupCommitLog.cpp CheckpointManager.cpp -o bench.exe
+if errorlevel 1 (
+    echo Benchmark compilation failed.
+)
+
+REM Compile and run the regression tests
+g++ -std=c++17 -O2 -pthread tests.cpp Client.cpp Wallet.cpp Blockchain.cpp Transaction.cpp TransactionList.cpp ClientBST.cpp MappedFile.cpp LedgerParser.cpp Snapshot.cpp TransactionLog.cpp WorkerPool.cpp Money.cpp Sha256.cpp Block.cpp IdTable.cpp LedgerMetrics.cpp RangeIndex.cpp BloomFilter.cpp IdArchive.cpp ShardedLedger.cpp LedgerServer.cpp GroupCommitLog.cpp CheckpointManager.cpp -o tests.exe
+if errorlevel 1 (
+    echo Tests compilation failed.
+    pause
+    exit /b 1
+)
+tests.exe
+if errorlevel 1 (
+    echo Tests failed.
+    pause
+    exit /b 1
+)
+
 REM Run the program
 echo Compilation succeeded. Running the program...
 main.exe
@@ -0,0 +1,233 @@
+// Load generator for the --serve mode of main: opens connections to a LedgerServer, pipelines
+// transfer and balance requests on each and measures the round trip of every request.
+//
+// Usage: loadgen --endpoint <port | unix socket path> --clients <clients file> [--connections N]
+//                [--depth N] [--requests N] [--balance-ratio R] [--seed N]
+//
+// Wallet IDs are read from the "W;id;balance" lines of the clients file the server was started
+// with. Each connection runs on its own thread and keeps up to --depth requests in flight; the
+// report gives the overall throughput and the p50/p90/p99/p99.9/max request latencies.
+// Linux only (POSIX sockets).
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Workload parameters
+struct LoadConfig {
+    std::string endpoint;
+    std::string clientsFile;
+    std::size_t connections = 4;
+    std::size_t depth = 32;              // Requests in flight per connection
+    std::size_t requests = 50000;        // Requests per connection
+    double balanceRatio = 0.1;           // Share of balance queries; the rest are transfers
+    unsigned seed = 42;
+};
+
+// Outcome of one connection
+struct ConnectionResult {
+    std::vector<std::uint64_t> latencies;  // ns, one per answered request
+    std::size_t ok = 0;                    // OK and BAL answers
+    std::size_t errors = 0;                // ERR answers
+    bool failed = false;                   // Connect, read or write error
+};
+
+// Opens a blocking connection to 127.0.0.1:<port> or to a Unix socket path; -1 on error
+static int connectTo(const std::string& endpoint) {
+    bool isPort = !endpoint.empty() && endpoint.find_first_not_of("0123456789") == std::string::npos;
+    if (isPort) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(std::strtoul(endpoint.c_str(), nullptr, 10)));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    sockaddr_un address{};
+    if (endpoint.size() >= sizeof(address.sun_path)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, endpoint.c_str(), endpoint.size() + 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool writeAll(int fd, const std::string& data) {
+    std::size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n <= 0) return false;
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// Drives one connection: keeps config.depth requests in flight until config.requests are answered
+static void runConnection(const LoadConfig& config, const std::vector<std::string>& wallets, std::size_t index,
+                          ConnectionResult& result) {
+    int fd = connectTo(config.endpoint);
+    if (fd < 0) {
+        result.failed = true;
+        return;
+    }
+    std::mt19937_64 rng(config.seed + index);
+    std::uniform_int_distribution<std::size_t> pickWallet(0, wallets.size() - 1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<int> pickAmount(1, 100);
+    // Unique across connections and runs, so the server never sees a duplicate ID
+    const std::string idPrefix = "lg" + std::to_string(::getpid()) + "-" + std::to_string(index) + "-";
+
+    result.latencies.reserve(config.requests);
+    std::deque<Clock::time_point> inFlight;   // Send times, answered in order
+    std::string request, input;
+    std::size_t sent = 0;
+    char buffer[65536];
+    while (result.latencies.size() < config.requests) {
+        // Top the pipeline up, then send the new requests in one write
+        request.clear();
+        Clock::time_point now = Clock::now();
+        while (inFlight.size() < config.depth && sent < config.requests) {
+            if (unit(rng) < config.balanceRatio) {
+                request += "B " + wallets[pickWallet(rng)] + "\n";
+            } else {
+                request += "T " + idPrefix + std::to_string(sent) + " " + wallets[pickWallet(rng)] + " " +
+                           wallets[pickWallet(rng)] + " " + std::to_string(pickAmount(rng)) + ".00\n";
+            }
+            inFlight.push_back(now);
+            ++sent;
+        }
+        if (!request.empty() && !writeAll(fd, request)) {
+            result.failed = true;
+            break;
+        }
+
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            result.failed = true;
+            break;
+        }
+        input.append(buffer, static_cast<std::size_t>(n));
+        Clock::time_point answered = Clock::now();
+        std::size_t start = 0, newline;
+        while ((newline = input.find('\n', start)) != std::string::npos && !inFlight.empty()) {
+            if (input.compare(start, 4, "ERR ") == 0) result.errors++;
+            else result.ok++;
+            result.latencies.push_back(static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(answered - inFlight.front()).count()));
+            inFlight.pop_front();
+            start = newline + 1;
+        }
+        input.erase(0, start);
+    }
+    ::close(fd);
+}
+
+// Reads the wallet IDs of the "W;id;balance" lines of a clients file
+static bool readWallets(const std::string& filename, std::vector<std::string>& wallets) {
+    std::ifstream file(filename);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 2, "W;") != 0) continue;
+        std::size_t end = line.find(';', 2);
+        if (end != std::string::npos && end > 2)
+            wallets.push_back(line.substr(2, end - 2));
+    }
+    return true;
+}
+
+// Parses the command line; false (after printing the usage) on anything unknown
+static bool parseArgs(int argc, char* argv[], LoadConfig& config) {
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i += 2) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        ok = value != nullptr;
+        if (!ok) break;
+        if (arg == "--endpoint") config.endpoint = value;
+        else if (arg == "--clients") config.clientsFile = value;
+        else if (arg == "--connections") config.connections = std::strtoull(value, nullptr, 10);
+        else if (arg == "--depth") config.depth = std::strtoull(value, nullptr, 10);
+        else if (arg == "--requests") config.requests = std::strtoull(value, nullptr, 10);
+        else if (arg == "--balance-ratio") config.balanceRatio = std::strtod(value, nullptr);
+        else if (arg == "--seed") config.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else ok = false;
+    }
+    if (!ok || config.endpoint.empty() || config.clientsFile.empty() || config.connections == 0 || config.depth == 0) {
+        std::fprintf(stderr, "Usage: %s --endpoint <port | unix socket path> --clients <clients file> "
+                             "[--connections N] [--depth N] [--requests N] [--balance-ratio R] [--seed N]\n", argv[0]);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    LoadConfig config;
+    if (!parseArgs(argc, argv, config))
+        return 2;
+
+    std::vector<std::string> wallets;
+    if (!readWallets(config.clientsFile, wallets) || wallets.empty()) {
+        std::fprintf(stderr, "No wallets in %s\n", config.clientsFile.c_str());
+        return 1;
+    }
+
+    std::vector<ConnectionResult> results(config.connections);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < config.connections; ++i)
+        threads.emplace_back(runConnection, std::cref(config), std::cref(wallets), i, std::ref(results[i]));
+    for (std::thread& thread : threads)
+        thread.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<std::uint64_t> latencies;
+    std::size_t ok = 0, errors = 0, failed = 0;
+    for (const ConnectionResult& result : results) {
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        ok += result.ok;
+        errors += result.errors;
+        if (result.failed) failed++;
+    }
+    if (failed)
+        std::fprintf(stderr, "%zu of %zu connection(s) failed\n", failed, config.connections);
+    if (latencies.empty())
+        return 1;
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return static_cast<double>(latencies[static_cast<std::size_t>(p * (latencies.size() - 1))]) / 1000.0;
+    };
+    std::printf("%zu connection(s), depth %zu: %zu requests in %.3f s (%.0f req/s)\n", config.connections,
+                config.depth, latencies.size(), seconds, latencies.size() / seconds);
+    std::printf("  answered OK: %zu, ERR: %zu\n", ok, errors);
+    std::printf("  latency us: p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", percentile(0.50),
+                percentile(0.90), percentile(0.99), percentile(0.999), latencies.back() / 1000.0);
+    return failed ? 1 : 0;
+}
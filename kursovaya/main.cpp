@@ -1,10 +1,22 @@
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <string>
-#include <functional>
 #include "Blockchain.h"
+#include "CheckpointManager.h"
 #include "Client.h"
 #include "Wallet.h"
 #include "Transaction.h"
+#include "Money.h"
+#include "ShardedLedger.h"
+#include "LedgerServer.h"
 
 void showMenu() {
     std::cout << "\n=== Blockchain Menu ===\n";
@@ -13,15 +25,274 @@ void showMenu() {
     std::cout << "3. Make a transaction\n";
     std::cout << "4. Display all transactions\n";
     std::cout << "5. Save data\n";
-    std::cout << "6. Load data\n";
+    std::cout << "6. Load data (replays the write-ahead log)\n";
+    std::cout << "7. Save snapshot\n";
+    std::cout << "8. Load snapshot\n";
+    std::cout << "9. Show metrics\n";
+    std::cout << "10. Show wallet history\n";
+    std::cout << "11. Search transactions by time\n";
     std::cout << "0. Exit\n";
     std::cout << "Choice: ";
 }
 
-int main() {
+// Reads an amount such as 150 or 99.95, asking again until the input is valid
+Money readMoney(const std::string& prompt) {
+    while (true) {
+        std::cout << prompt;
+        std::string input;
+        std::getline(std::cin, input);
+        Money value;
+        if (parseMoney(input, value))
+            return value;
+        if (!std::cin)
+            return 0;
+        std::cout << "Invalid amount, use at most two decimals.\n";
+    }
+}
+
+// Reads a local time "YYYY-MM-DD HH:MM[:SS]"; an empty line gives fallback.
+// withSeconds tells whether the seconds were typed (true for the fallback).
+Timestamp readTimestamp(const std::string& prompt, Timestamp fallback, bool& withSeconds) {
+    withSeconds = true;
+    while (true) {
+        std::cout << prompt;
+        std::string input;
+        std::getline(std::cin, input);
+        if (input.empty() || !std::cin)
+            return fallback;
+        std::tm local = {};
+        int fields = std::sscanf(input.c_str(), "%d-%d-%d %d:%d:%d", &local.tm_year, &local.tm_mon, &local.tm_mday,
+                                 &local.tm_hour, &local.tm_min, &local.tm_sec);
+        if (fields >= 5) {
+            withSeconds = fields == 6;
+            local.tm_year -= 1900;
+            local.tm_mon -= 1;
+            local.tm_isdst = -1;
+            std::time_t seconds = std::mktime(&local);
+            if (seconds != static_cast<std::time_t>(-1))
+                return static_cast<Timestamp>(seconds) * 1000;
+        }
+        std::cout << "Invalid time, use YYYY-MM-DD HH:MM[:SS].\n";
+    }
+}
+
+// Seconds elapsed since a start time
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Headless mode: main --replay <clients file> <transactions file> [output prefix]
+// Loads the clients, streams the transactions through processTransaction, writes the resulting
+// state to <prefix>clients.txt, <prefix>transactions.txt and <prefix>blocks.txt (prefix
+// defaults to "Replay_") and prints the counts and timings. No write-ahead log is used.
+static int runReplay(int argc, char* argv[]) {
+    if (argc < 4 || argc > 5) {
+        std::cerr << "Usage: " << argv[0] << " --replay <clients file> <transactions file> [output prefix]\n";
+        return 2;
+    }
+    const std::string clientsFile = argv[2];
+    const std::string transactionsFile = argv[3];
+    const std::string prefix = argc == 5 ? argv[4] : "Replay_";
+
+    Blockchain blockchain;
+    auto start = std::chrono::steady_clock::now();
+    std::cout << std::fixed << std::setprecision(3);
+
+    auto phase = std::chrono::steady_clock::now();
+    if (!blockchain.loadClientsFromFile(clientsFile)) {
+        std::cerr << "Cannot read " << clientsFile << "\n";
+        return 1;
+    }
+    std::cout << "Loaded " << clientsFile << " in " << secondsSince(phase) << " s\n";
+
+    phase = std::chrono::steady_clock::now();
+    ReplayStats stats;
+    if (!blockchain.processTransactionFile(transactionsFile, stats)) {
+        std::cerr << "Cannot read " << transactionsFile << "\n";
+        return 1;
+    }
+    double replaySeconds = secondsSince(phase);
+    std::size_t processed = stats.accepted + stats.rejected + stats.duplicates;
+    std::cout << "Processed " << processed << " transactions in " << replaySeconds << " s ("
+              << static_cast<unsigned long long>(replaySeconds > 0 ? processed / replaySeconds : 0.0) << " tx/s)\n";
+    std::cout << "  accepted:  " << stats.accepted << "\n";
+    std::cout << "  rejected:  " << stats.rejected << "\n";
+    std::cout << "  malformed: " << stats.malformed << "\n";
+    std::cout << "  duplicate: " << stats.duplicates << "\n";
+
+    phase = std::chrono::steady_clock::now();
+    blockchain.sealBlock();  // Seal the trailing partial block so every transaction is covered
+    if (!blockchain.saveClientsToFile(prefix + "clients.txt") ||
+        !blockchain.saveTransactionsToFile(prefix + "transactions.txt") ||
+        !blockchain.saveBlocksToFile(prefix + "blocks.txt")) {
+        std::cerr << "Cannot write the " << prefix << "* output files\n";
+        return 1;
+    }
+    std::cout << "Wrote " << prefix << "clients.txt, " << prefix << "transactions.txt and " << prefix
+              << "blocks.txt in " << secondsSince(phase) << " s\n";
+
+    std::cout << "Wall time: " << secondsSince(start) << " s\n\n";
+    blockchain.dumpMetrics(std::cout);
+    return 0;
+}
+
+// Headless sharded mode: main --replay-sharded <shards> <clients file> <transactions file> [file prefix]
+// Same as --replay on a ShardedLedger: wallets are spread over the shards, transfers are committed
+// in batches (same-shard ones in parallel, cross-shard ones through the intent log) and the shard
+// snapshots are written under the prefix (default "Sharded_") at the end.
+static int runShardedReplay(int argc, char* argv[]) {
+    std::size_t shardCount = argc >= 5 ? std::strtoul(argv[2], nullptr, 10) : 0;
+    if (argc < 5 || argc > 6 || shardCount == 0) {
+        std::cerr << "Usage: " << argv[0]
+                  << " --replay-sharded <shards> <clients file> <transactions file> [file prefix]\n";
+        return 2;
+    }
+    const std::string clientsFile = argv[3];
+    const std::string transactionsFile = argv[4];
+    const std::string prefix = argc == 6 ? argv[5] : "Sharded_";
+
+    ShardedLedger ledger(shardCount, prefix);
+    auto start = std::chrono::steady_clock::now();
+    std::cout << std::fixed << std::setprecision(3);
+    if (!ledger.open()) {
+        std::cerr << "Cannot open the " << prefix << "* shard files\n";
+        return 1;
+    }
+
+    auto phase = std::chrono::steady_clock::now();
+    if (!ledger.loadClientsFromFile(clientsFile)) {
+        std::cerr << "Cannot read " << clientsFile << "\n";
+        return 1;
+    }
+    std::cout << "Loaded " << clientsFile << " into " << shardCount << " shard(s) in " << secondsSince(phase) << " s\n";
+
+    phase = std::chrono::steady_clock::now();
+    ReplayStats stats;
+    if (!ledger.processTransactionFile(transactionsFile, stats)) {
+        std::cerr << "Cannot read " << transactionsFile << "\n";
+        return 1;
+    }
+    double replaySeconds = secondsSince(phase);
+    std::size_t processed = stats.accepted + stats.rejected + stats.duplicates;
+    std::cout << "Processed " << processed << " transactions in " << replaySeconds << " s ("
+              << static_cast<unsigned long long>(replaySeconds > 0 ? processed / replaySeconds : 0.0) << " tx/s)\n";
+    std::cout << "  accepted:  " << stats.accepted << "\n";
+    std::cout << "  rejected:  " << stats.rejected << "\n";
+    std::cout << "  malformed: " << stats.malformed << "\n";
+    std::cout << "  duplicate: " << stats.duplicates << "\n";
+    for (std::size_t k = 0; k < ledger.getShardCount(); ++k) {
+        MetricsSnapshot shard = ledger.getShard(k).getMetrics();
+        std::cout << "  shard " << k << ": " << shard.wallets << " wallets, " << shard.transactions << " records\n";
+    }
+
+    phase = std::chrono::steady_clock::now();
+    if (!ledger.save()) {
+        std::cerr << "Cannot write the " << prefix << "* shard files\n";
+        return 1;
+    }
+    std::cout << "Saved the shard snapshots in " << secondsSince(phase) << " s\n";
+    std::cout << "Wall time: " << secondsSince(start) << " s\n";
+    return 0;
+}
+
+// Set by SIGINT/SIGTERM to stop the server loop
+static volatile std::sig_atomic_t stopServer = 0;
+
+static void requestStop(int) {
+    stopServer = 1;
+}
+
+// Server mode: main --serve <clients file> <port | unix socket path> [state prefix [group size [interval ms [checkpoint every]]]]
+// Without a state prefix, serves the clients file in memory only. With one, the state lives in
+// checkpointed log segments under the prefix (see CheckpointManager): startup loads the newest
+// checkpoint (the clients file only when there is none yet) and replays the log tail; commits go
+// to a group-commit log (a group is synced at <group size> records, default 4096, or <interval
+// ms>, default 2, after its first one); a checkpoint is taken every <checkpoint every> commits
+// (default 100000) and on shutdown. Serves the LedgerServer line protocol on 127.0.0.1:<port>
+// (an all-digit argument) or on a Unix socket until interrupted, then prints the server and log
+// counters and the ledger metrics.
+static int runServe(int argc, char* argv[]) {
+    if (argc < 4 || argc > 8) {
+        std::cerr << "Usage: " << argv[0] << " --serve <clients file> <port | unix socket path>"
+                  << " [state prefix [group size [interval ms [checkpoint every]]]]\n";
+        return 2;
+    }
+    const std::string clientsFile = argv[2];
+    const std::string endpoint = argv[3];
+
+    Blockchain blockchain;
+    std::unique_ptr<CheckpointManager> checkpoints;
+    if (argc >= 5) {
+        CheckpointConfig config;
+        config.groupCommit = true;
+        if (argc >= 6) config.group.batchSize = std::strtoul(argv[5], nullptr, 10);
+        if (argc >= 7) config.group.flushIntervalMs = static_cast<std::uint32_t>(std::strtoul(argv[6], nullptr, 10));
+        if (argc >= 8) config.everyTransactions = std::strtoul(argv[7], nullptr, 10);
+        auto start = std::chrono::steady_clock::now();
+        checkpoints.reset(new CheckpointManager(blockchain, argv[4], config));
+        if (!checkpoints->recover(clientsFile))
+            return 1;
+        std::cout << "Recovered " << argv[4] << "* up to log segment " << checkpoints->getSegment() << " in "
+                  << std::fixed << std::setprecision(3) << secondsSince(start) << " s\n";
+    } else if (!blockchain.loadClientsFromFile(clientsFile)) {
+        std::cerr << "Cannot read " << clientsFile << "\n";
+        return 1;
+    }
+
+    LedgerServer server(blockchain);
+    server.setCheckpoints(checkpoints.get());
+    bool isPort = endpoint.find_first_not_of("0123456789") == std::string::npos;
+    unsigned long port = isPort ? std::strtoul(endpoint.c_str(), nullptr, 10) : 0;
+    if (isPort && (port == 0 || port > 65535)) {
+        std::cerr << "Invalid port " << endpoint << "\n";
+        return 2;
+    }
+    if (isPort ? !server.listenTcp(static_cast<std::uint16_t>(port)) : !server.listenUnix(endpoint)) {
+        std::cerr << "Cannot listen on " << endpoint << "\n";
+        return 1;
+    }
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    std::cout << "Serving on " << (isPort ? "127.0.0.1:" : "") << endpoint << " (Ctrl+C to stop)" << std::endl;
+    if (!server.run(stopServer))
+        return 1;
+
+    const ServerStats& stats = server.getStats();
+    std::cout << "\nConnections: " << stats.connections << "\n";
+    std::cout << "Requests:    " << stats.requests << "\n";
+    std::cout << "Transfers:   " << stats.transfers << " in " << stats.batches << " batch(es)\n";
+    if (blockchain.getGroupCommitLog().isOpen()) {
+        blockchain.syncLog();
+        GroupCommitStats logStats = blockchain.getGroupCommitLog().getStats();
+        std::cout << "Log:         " << logStats.records << " record(s) in " << logStats.groups << " sync(s)";
+        if (logStats.failures) std::cout << ", " << logStats.failures << " failed";
+        std::cout << "\n";
+    }
+    // A final checkpoint, so the next start has no tail to replay
+    if (checkpoints && (!checkpoints->checkpoint() || !checkpoints->wait()))
+        std::cerr << "Cannot write the final checkpoint\n";
+    std::cout << "\n";
+    blockchain.dumpMetrics(std::cout);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--replay") == 0)
+        return runReplay(argc, argv);
+    if (argc > 1 && std::strcmp(argv[1], "--replay-sharded") == 0)
+        return runShardedReplay(argc, argv);
+    if (argc > 1 && std::strcmp(argv[1], "--serve") == 0)
+        return runServe(argc, argv);
+
     Blockchain blockchain;
     bool running = true;
 
+    // Transactions committed since the last save are kept in the write-ahead log
+    const std::string logFile = "Blockchain_wal.txt";
+    if (!blockchain.openLog(logFile))
+        std::cout << "Warning: cannot open " << logFile << ", transactions will not be logged.\n";
+
     while (running) {
         showMenu();
         int choice;
@@ -37,16 +308,19 @@ int main() {
                 std::getline(std::cin, name);
                 std::cout << "Client type (Standard, Gold, Platinum): ";
                 std::getline(std::cin, type);
+                if (!isRecordField(id) || !isRecordField(name)) {
+                    std::cout << "Client ID and name must not be empty or contain ';' or control characters.\n";
+                    break;
+                }
 
-                Client* client = nullptr;
-                if (type == "Gold")
-                    client = new GoldClient(id, name);
-                else if (type == "Platinum")
-                    client = new PlatinumClient(id, name);
-                else
-                    client = new StandardClient(id, name);
-
-                blockchain.addClient(client);
+                // Unknown tier names create a Standard client
+                ClientTier tier = ClientTier::STANDARD;
+                tierFromName(type, tier);
+                Client* client = blockchain.addClient(id, name, tier);
+                if (!client) {
+                    std::cout << "A client with this ID already exists.\n";
+                    break;
+                }
 
                 int walletCount;
                 std::cout << "How many wallets to add for this client? ";
@@ -55,20 +329,19 @@ int main() {
 
                 for (int i = 0; i < walletCount; ++i) {
                     std::string walletId;
-                    double balance;
 
                     std::cout << "Wallet #" << (i + 1) << " ID: ";
                     std::getline(std::cin, walletId);
 
-                    std::cout << "Initial balance: ";
-                    std::cin >> balance;
-                    std::cin.ignore();
-
-                    Wallet* wallet = new Wallet(walletId, client->getId(), balance);
-                    client->addWallet(wallet);
+                    Money balance = readMoney("Initial balance: ");
+                    if (!isRecordField(walletId)) {
+                        std::cout << "Wallet ID must not be empty or contain ';' or control characters.\n";
+                        continue;
+                    }
 
-                    // Important : indexer ce wallet dans la blockchain
-                    blockchain.indexWallet(wallet);
+                    // Important : le wallet est créé et indexé par la blockchain
+                    if (!blockchain.createWallet(client, walletId, balance))
+                        std::cout << "A wallet with this ID already exists.\n";
                 }
 
                 std::cout << "Client and wallets added.\n";
@@ -79,7 +352,6 @@ int main() {
                 break;
             case 3: {
                 std::string txId, senderWalletId, recipientWalletId;
-                double amount;
 
                 std::cout << "Transaction ID: ";
                 std::getline(std::cin, txId);
@@ -87,59 +359,125 @@ int main() {
                 std::getline(std::cin, senderWalletId);
                 std::cout << "Recipient wallet ID: ";
                 std::getline(std::cin, recipientWalletId);
-                std::cout << "Amount: ";
-                std::cin >> amount;
-                std::cin.ignore();
+                Money amount = readMoney("Amount: ");
+                if (!isRecordField(txId) || !isRecordField(senderWalletId) || !isRecordField(recipientWalletId)) {
+                    std::cout << "IDs must not be empty or contain ';' or control characters.\n";
+                    break;
+                }
 
-                Wallet* senderWallet = blockchain.findWalletById(senderWalletId);
-                if (!senderWallet) {
+                const WalletRef* sender = blockchain.findWalletRef(senderWalletId);
+                if (!sender) {
                     std::cout << "Sender wallet not found.\n";
                     break;
                 }
 
-                Client* senderClient = nullptr;
-                std::function<ClientNode*(ClientNode*, Wallet*)> findClientNodeByWallet = [&](ClientNode* node, Wallet* w) -> ClientNode* {
-                    if (!node) return nullptr;
-                    const auto& ws = node->data->getWallets().getAllEntities();
-                    for (Entity* e : ws) {
-                        if (e->getId() == w->getId()) return node;
-                    }
-                    ClientNode* found = findClientNodeByWallet(node->left, w);
-                    if (found) return found;
-                    return findClientNodeByWallet(node->right, w);
-                };
-
-                ClientNode* senderNode = findClientNodeByWallet(blockchain.getRoot(), senderWallet);
-                if (!senderNode) {
+                Client* senderClient = sender->owner;
+                if (!senderClient) {
                     std::cout << "Sender client not found.\n";
                     break;
                 }
-                senderClient = senderNode->data;
 
-                double commission = senderClient->calculateCommission(amount);
+                Money commission = senderClient->calculateCommission(amount);
 
-                Transaction* tx = new Transaction(txId, senderWalletId, recipientWalletId, amount, TxType::TRANSFER, commission);
-                if (blockchain.processTransaction(tx))
+                TxStatus status = blockchain.processTransaction(
+                    Transaction(txId, senderWalletId, recipientWalletId, amount, TxType::TRANSFER, commission));
+                if (status == TxStatus::OK)
                     std::cout << "Transaction successful.\n";
                 else
-                    std::cout << "Transaction failed.\n";
+                    std::cout << "Transaction failed: " << txStatusMessage(status) << "\n";
                 break;
             }
             case 4:
                 blockchain.displayTransactions();
                 break;
             case 5:
-                if (blockchain.saveClientsToFile("Clients.txt") && blockchain.saveTransactionsToFile("Blockchain_transactions.txt"))
+                if (blockchain.saveClientsToFile("Clients.txt") && blockchain.saveTransactionsToFile("Blockchain_transactions.txt") &&
+                    blockchain.saveBlocksToFile("Blockchain_blocks.txt")) {
+                    // The saved files now contain everything the log recorded
+                    blockchain.resetLog();
                     std::cout << "Data saved successfully.\n";
+                }
                 else
                     std::cout << "Error saving data.\n";
                 break;
             case 6:
-                if (blockchain.loadClientsFromFile("Clients.txt") && blockchain.loadTransactionsFromFile("Blockchain_transactions.txt"))
+                if (blockchain.loadClientsFromFile("Clients.txt") && blockchain.loadTransactionsFromFile("Blockchain_transactions.txt")) {
+                    // Block headers are optional (histories saved before blocks existed have none)
+                    blockchain.loadBlocksFromFile("Blockchain_blocks.txt");
+                    // Re-apply what was committed after the last save (a missing log means nothing to replay)
+                    blockchain.replayLog(logFile);
                     std::cout << "Data loaded successfully.\n";
+
+                    VerificationReport report = blockchain.verifyLedger();
+                    if (report.ok) {
+                        std::cout << "Ledger verified: " << report.transactionsChecked << " transactions, "
+                                  << report.blocksChecked << " blocks.\n";
+                    } else {
+                        std::cout << "Ledger verification failed.\n";
+                        if (!report.divergence.empty()) std::cout << "  " << report.divergence << "\n";
+                        if (!report.blockDivergence.empty()) std::cout << "  " << report.blockDivergence << "\n";
+                    }
+                }
                 else
                     std::cout << "Error loading data.\n";
                 break;
+            case 7:
+                if (blockchain.saveSnapshot("Blockchain.snapshot"))
+                    std::cout << "Snapshot saved successfully.\n";
+                else
+                    std::cout << "Error saving snapshot.\n";
+                break;
+            case 8:
+                if (blockchain.loadSnapshot("Blockchain.snapshot"))
+                    std::cout << "Snapshot loaded successfully.\n";
+                else
+                    std::cout << "Error loading snapshot.\n";
+                break;
+            case 9:
+                blockchain.dumpMetrics(std::cout);
+                break;
+            case 10: {
+                const std::size_t pageSize = 10;
+                std::string walletId;
+                std::cout << "Wallet ID: ";
+                std::getline(std::cin, walletId);
+                std::size_t total = blockchain.getWalletHistorySize(walletId);
+                std::size_t pages = (total + pageSize - 1) / pageSize;
+
+                std::size_t page = 1;
+                if (pages > 1) {
+                    std::cout << "Page (1-" << pages << "): ";
+                    std::cin >> page;
+                    std::cin.ignore();
+                    if (page < 1 || page > pages) page = 1;
+                }
+
+                std::cout << total << " transaction(s), newest first";
+                if (pages > 1) std::cout << ", page " << page << " of " << pages;
+                std::cout << ":\n";
+                for (const Transaction* tx : blockchain.getWalletHistory(walletId, (page - 1) * pageSize, pageSize))
+                    std::cout << "  " << tx->getDetails() << "\n";
+                break;
+            }
+            case 11: {
+                bool fromSeconds, toSeconds;
+                Timestamp from = readTimestamp("From (YYYY-MM-DD HH:MM[:SS], empty = beginning): ", 0, fromSeconds);
+                Timestamp to = readTimestamp("To (YYYY-MM-DD HH:MM[:SS], empty = no limit): ", INT64_MAX, toSeconds);
+                // A "to" minute is included in full, a "to" second up to its last millisecond
+                to += to == INT64_MAX ? 0 : toSeconds ? 999 : 59999;
+                std::string input;
+                std::cout << "Only transfers above (empty = all): ";
+                std::getline(std::cin, input);
+                Money minimum = 0;
+                bool filtered = !input.empty() && parseMoney(input, minimum);
+
+                std::vector<const Transaction*> found = filtered ? blockchain.getTransfersAbove(minimum, from, to)
+                                                                 : blockchain.getTransactionsBetween(from, to);
+                std::cout << found.size() << " transaction(s):\n";
+                for (const Transaction* tx : found)
+                    std::cout << "  " << tx->getDetails() << "\n";
+                break;
+            }
             case 0:
                 running = false;
                 break;
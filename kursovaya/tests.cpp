@@ -0,0 +1,467 @@
+// Regression tests of the durability paths: write-ahead log replay, checkpoint recovery and the
+// two-phase protocol of the sharded ledger. Each test works in its own scratch directory under
+// the system temporary directory and prints one line; the exit status is 1 if any check failed.
+//
+// Usage: tests
+#include "Block.h"
+#include "Blockchain.h"
+#include "CheckpointManager.h"
+#include "LedgerParser.h"
+#include "ShardedLedger.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+static int failedChecks = 0;
+
+static void check(bool ok, const char* expression, const char* file, int line) {
+    if (ok) return;
+    std::printf("  %s:%d: check failed: %s\n", file, line, expression);
+    failedChecks++;
+}
+
+#define CHECK(expression) check((expression), #expression, __FILE__, __LINE__)
+
+// Empty directory for one test; returns it as a path prefix ending with a separator
+static std::string scratch(const std::string& name) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "ledger_tests" / name;
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+    std::filesystem::create_directories(directory);
+    return directory.string() + "/";
+}
+
+static std::string walletId(std::size_t i) { return "w" + std::to_string(i); }
+
+// Writes a clients file: clients c0..c<clients-1>, wallets w0..w<wallets-1> dealt round-robin, all
+// with the same opening balance except the last `empty` wallets, which start at 0
+static void writeBook(const std::string& filename, std::size_t clients, std::size_t wallets, Money balance,
+                      std::size_t empty = 0) {
+    std::ofstream file(filename);
+    const char* tiers[] = {"Standard", "Gold", "Platinum"};
+    for (std::size_t c = 0; c < clients; ++c) {
+        file << "c" << c << ";client " << c << ";" << tiers[c % 3] << "\n";
+        for (std::size_t w = c; w < wallets; w += clients)
+            file << "W;" << walletId(w) << ";" << formatMoney(w + empty >= wallets ? 0 : balance) << "\n";
+    }
+}
+
+// Transfers between random wallets whose amounts often exceed what the sender holds, so the
+// outcome depends on the order they commit in
+static std::vector<Transaction> randomTransfers(const std::string& prefix, std::size_t count, std::size_t wallets,
+                                                unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> pickWallet(0, wallets - 1);
+    std::uniform_int_distribution<int> pickAmount(1, 60);
+    std::vector<Transaction> transfers;
+    for (std::size_t i = 0; i < count; ++i) {
+        Money amount = money(pickAmount(rng));
+        transfers.emplace_back(prefix + std::to_string(i), walletId(pickWallet(rng)), walletId(pickWallet(rng)),
+                               amount, TxType::TRANSFER, amount / 100);
+    }
+    return transfers;
+}
+
+// Commits copies of the transfers as one batch; threads == 0 runs processTransactions
+static std::vector<TxStatus> commitBatch(Blockchain& ledger, const std::vector<Transaction>& transfers,
+                                         std::size_t threads) {
+    std::vector<Transaction*> batch;
+    for (const Transaction& tx : transfers)
+        batch.push_back(new Transaction(tx));
+    std::vector<TxStatus> statuses = threads == 0 ? ledger.processTransactions(batch.data(), batch.size())
+                                                  : ledger.processTransactionsParallel(batch.data(), batch.size(), threads);
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (statuses[i] != TxStatus::OK) delete batch[i];
+    }
+    return statuses;
+}
+
+static bool sameBalances(const Blockchain& a, const Blockchain& b, std::size_t wallets) {
+    for (std::size_t i = 0; i < wallets; ++i) {
+        if (a.findWalletById(walletId(i))->getBalance() != b.findWalletById(walletId(i))->getBalance())
+            return false;
+    }
+    return true;
+}
+
+// Every intake path, parallel batches included, logs what replays to the live state
+static void testLogReplayMatchesLiveState(bool groupCommit) {
+    const std::string dir = scratch(groupCommit ? "replay_group" : "replay_sync");
+    const std::size_t wallets = 200;
+    writeBook(dir + "clients.txt", 20, wallets, money(100), 10);
+
+    Blockchain live, serial;
+    CHECK(live.loadClientsFromFile(dir + "clients.txt"));
+    CHECK(serial.loadClientsFromFile(dir + "clients.txt"));
+    CHECK(groupCommit ? live.openGroupCommitLog(dir + "wal.txt", GroupCommitConfig())
+                      : live.openLog(dir + "wal.txt"));
+
+    // A transfer out of an empty wallet that the next one funds: committed in the wrong order,
+    // the second would succeed on the live ledger and the first on replay
+    std::vector<Transaction> conflict = randomTransfers("p", 600, wallets - 10, 1);
+    conflict[255] = Transaction("a-to-b", walletId(wallets - 1), walletId(0), money(50), TxType::TRANSFER, 0);
+    conflict[256] = Transaction("c-to-a", walletId(1), walletId(wallets - 1), money(50), TxType::TRANSFER, 0);
+
+    std::vector<std::vector<Transaction>> batches = {conflict, randomTransfers("q", 3000, wallets, 2),
+                                                     randomTransfers("r", 2000, wallets, 3)};
+    for (std::size_t b = 0; b < batches.size(); ++b) {
+        std::vector<TxStatus> expected = commitBatch(serial, batches[b], 0);
+        CHECK(commitBatch(live, batches[b], b == 1 ? 0 : 4) == expected);
+    }
+    CHECK(live.processTransaction(Transaction("single", walletId(2), walletId(3), money(1), TxType::TRANSFER, 0)) ==
+          serial.processTransaction(Transaction("single", walletId(2), walletId(3), money(1), TxType::TRANSFER, 0)));
+    CHECK(sameBalances(live, serial, wallets));
+    CHECK(live.syncLog());
+
+    Blockchain replayed;
+    CHECK(replayed.loadClientsFromFile(dir + "clients.txt"));
+    CHECK(replayed.replayLog(dir + "wal.txt"));
+    CHECK(sameBalances(live, replayed, wallets));
+    CHECK(replayed.getMetrics().transactions == live.getMetrics().transactions);
+    CHECK(replayed.verifyLedger(2).ok);
+}
+
+static void testSyncLogReplay() { testLogReplayMatchesLiveState(false); }
+static void testGroupCommitLogReplay() { testLogReplayMatchesLiveState(true); }
+
+// A non-positive amount or a negative commission would mint money: refused live, on replay and on load
+static void testInvalidAmountsRefused() {
+    const std::string dir = scratch("amounts");
+    writeBook(dir + "clients.txt", 2, 4, money(100));
+    Blockchain ledger;
+    CHECK(ledger.loadClientsFromFile(dir + "clients.txt"));
+    CHECK(ledger.processTransaction(Transaction("fee", walletId(0), walletId(1), money(10), TxType::TRANSFER,
+                                                money(-90))) == TxStatus::INVALID_AMOUNT);
+    CHECK(ledger.processTransaction(Transaction("zero", walletId(0), walletId(1), 0, TxType::TRANSFER, 0)) ==
+          TxStatus::INVALID_AMOUNT);
+    CHECK(ledger.processTransaction(Transaction("credit", walletId(0), walletId(1), money(-5), TxType::CREDIT, 0)) ==
+          TxStatus::INVALID_AMOUNT);
+    CHECK(ledger.findWalletById(walletId(0))->getBalance() == money(100));
+    CHECK(ledger.findWalletById(walletId(1))->getBalance() == money(100));
+
+    // Records written by hand (or by an older build): only the valid one replays
+    {
+        std::ofstream log(dir + "wal.txt");
+        log << "bad;" << walletId(0) << ";" << walletId(1) << ";10.00;-90.00;1700000000000\n";
+        log << "good;" << walletId(0) << ";" << walletId(1) << ";10.00;1.00;1700000000001\n";
+    }
+    Blockchain replayed;
+    CHECK(replayed.loadClientsFromFile(dir + "clients.txt"));
+    CHECK(replayed.replayLog(dir + "wal.txt"));
+    CHECK(!replayed.hasTransaction("bad") && replayed.hasTransaction("good"));
+    CHECK(replayed.findWalletById(walletId(0))->getBalance() == money(89));
+    CHECK(replayed.verifyLedger(1).ok);
+
+    Blockchain loaded;
+    CHECK(loaded.loadTransactionsFromFile(dir + "wal.txt"));
+    CHECK(!loaded.hasTransaction("bad") && loaded.hasTransaction("good"));
+
+    // Commit times are unsigned like the other counters of a record
+    TransactionRecord record;
+    CHECK(LedgerParser::parseTransactionRecord("t;a;b;1.00;0.00;1700000000000", record));
+    CHECK(!LedgerParser::parseTransactionRecord("t;a;b;1.00;0.00;-5", record));
+}
+
+// Leaves and inner nodes hash differently and an odd node is promoted, so neither a repeated
+// last leaf nor a subtree root passes for other leaves; blocks that do not match are sealed again
+static void testMerkleTreeShape() {
+    std::vector<Hash256> leaves;
+    for (int i = 0; i < 3; ++i)
+        leaves.push_back(hashTransaction(Transaction("m" + std::to_string(i), "a", "b", money(1), TxType::TRANSFER, 0)));
+    std::vector<Hash256> repeated = leaves;
+    repeated.push_back(leaves.back());
+    CHECK(computeMerkleRoot(leaves, nullptr) != computeMerkleRoot(repeated, nullptr));
+    CHECK(computeMerkleRoot({leaves[0]}, nullptr) == leaves[0]);
+    Hash256 pair = computeMerkleRoot({leaves[0], leaves[1]}, nullptr);
+    CHECK(computeMerkleRoot({leaves[0], leaves[1], leaves[2]}, nullptr) == computeMerkleRoot({pair, leaves[2]}, nullptr));
+    CHECK(computeMerkleRoot({pair}, nullptr) != hashTransaction(Transaction("m0", "a", "b", money(1), TxType::TRANSFER, 0)));
+
+    const std::string dir = scratch("merkle");
+    writeBook(dir + "clients.txt", 2, 4, money(100));
+    Blockchain ledger;
+    CHECK(ledger.loadClientsFromFile(dir + "clients.txt"));
+    ledger.setBlockSize(3);
+    commitBatch(ledger, randomTransfers("t", 10, 4, 7), 0);
+    CHECK(ledger.sealBlock());
+    CHECK(ledger.saveTransactionsToFile(dir + "transactions.txt"));
+    CHECK(ledger.saveBlocksToFile(dir + "blocks.txt"));
+
+    Blockchain reloaded;
+    CHECK(reloaded.loadTransactionsFromFile(dir + "transactions.txt"));
+    CHECK(reloaded.loadBlocksFromFile(dir + "blocks.txt"));
+    CHECK(reloaded.getBlocks().size() == ledger.getBlocks().size());
+    CHECK(reloaded.getBlocks().back().hash == ledger.getBlocks().back().hash);
+
+    // A first root from another tree (an older build's) drops the file's blocks
+    {
+        std::ifstream in(dir + "blocks.txt");
+        std::string first, rest, line;
+        std::getline(in, first);
+        while (std::getline(in, line)) rest += line + "\n";
+        std::size_t root = first.rfind(';', first.rfind(';') - 1) + 1;
+        first[root] = first[root] == '0' ? '1' : '0';
+        std::ofstream out(dir + "blocks.txt");
+        out << first << "\n" << rest;
+    }
+    Blockchain stale;
+    CHECK(stale.loadTransactionsFromFile(dir + "transactions.txt"));
+    CHECK(stale.loadBlocksFromFile(dir + "blocks.txt"));
+    CHECK(stale.getBlocks().empty());
+}
+
+// A wallet ID stays with the client that registered it first, in every loader and in createWallet
+static void testDuplicateWalletRefused() {
+    const std::string dir = scratch("wallets");
+    writeBook(dir + "clients.txt", 2, 4, money(100));
+    {
+        std::ofstream file(dir + "clients.txt", std::ios::app);
+        file << "c9;late client;Gold\nW;" << walletId(0) << ";500.00\n";
+    }
+    Blockchain ledger;
+    CHECK(ledger.loadClientsFromFile(dir + "clients.txt"));
+    CHECK(ledger.findClientByWallet(walletId(0)) == ledger.findClientById("c0"));
+    CHECK(ledger.findWalletById(walletId(0))->getBalance() == money(100));
+    CHECK(ledger.findClientById("c9")->getWalletCount() == 0);
+    CHECK(ledger.createWallet(ledger.findClientById("c1"), walletId(0), money(1)) == nullptr);
+    CHECK(ledger.findClientById("c1")->getTotalBalance() == money(200));
+
+    ShardedLedger sharded(2, dir);
+    CHECK(sharded.loadClientsFromFile(dir + "clients.txt"));
+    CHECK(sharded.findWalletById(walletId(0))->getOwner()->getId() == "c0");
+}
+
+// IDs committed before a checkpoint stay duplicates after recovering from it and its log tail
+static void testCheckpointRecoveryRejectsEarlierIds() {
+    const std::string dir = scratch("checkpoint");
+    writeBook(dir + "clients.txt", 4, 16, money(1000));
+    CheckpointConfig config;
+    config.everyTransactions = 0;  // Checkpoints are taken by hand below
+    auto transfer = [](const char* id) {
+        return Transaction(id, walletId(0), walletId(1), money(10), TxType::TRANSFER, 0);
+    };
+
+    Money sender, recipient;
+    {
+        Blockchain ledger;
+        CheckpointManager manager(ledger, dir, config);
+        CHECK(manager.recover(dir + "clients.txt"));
+        CHECK(ledger.processTransaction(transfer("before")) == TxStatus::OK);
+        CHECK(manager.checkpoint());
+        CHECK(manager.wait());
+        CHECK(ledger.processTransaction(transfer("after")) == TxStatus::OK);  // Only in the log tail
+        CHECK(ledger.syncLog());
+        sender = ledger.findWalletById(walletId(0))->getBalance();
+        recipient = ledger.findWalletById(walletId(1))->getBalance();
+    }
+
+    // Twice: the second recovery starts from a checkpoint taken by a recovered ledger
+    for (int round = 0; round < 2; ++round) {
+        Blockchain ledger;
+        CheckpointManager manager(ledger, dir, config);
+        CHECK(manager.recover(dir + "clients.txt"));
+        CHECK(ledger.findWalletById(walletId(0))->getBalance() == sender);
+        CHECK(ledger.findWalletById(walletId(1))->getBalance() == recipient);
+        CHECK(ledger.processTransaction(transfer("before")) == TxStatus::DUPLICATE_ID);
+        CHECK(ledger.processTransaction(transfer("after")) == TxStatus::DUPLICATE_ID);
+        std::vector<Transaction> batch = {transfer("before"), transfer(round == 0 ? "fresh0" : "fresh1")};
+        CHECK(commitBatch(ledger, batch, 0) == std::vector<TxStatus>({TxStatus::DUPLICATE_ID, TxStatus::OK}));
+        CHECK(ledger.hasTransaction("before"));
+        CHECK(manager.checkpoint());
+        CHECK(manager.wait());
+        CHECK(ledger.processTransaction(transfer(round == 0 ? "next0" : "next1")) == TxStatus::OK);
+        CHECK(ledger.syncLog());
+        sender = ledger.findWalletById(walletId(0))->getBalance();
+        recipient = ledger.findWalletById(walletId(1))->getBalance();
+    }
+}
+
+// Each checkpoint archives its segments' IDs in a run; runs merge so their number stays logarithmic
+static void testIdArchiveMergesRuns() {
+    const std::string dir = scratch("idarchive");
+    writeBook(dir + "clients.txt", 4, 16, money(1000));
+    CheckpointConfig config;
+    config.everyTransactions = 0;
+    const std::size_t checkpoints = 40, perCheckpoint = 5;
+    auto transfer = [](std::size_t i) {
+        return Transaction("t" + std::to_string(i), walletId(i % 16), walletId((i + 1) % 16), money(1),
+                           TxType::TRANSFER, 0);
+    };
+    {
+        Blockchain ledger;
+        CheckpointManager manager(ledger, dir, config);
+        CHECK(manager.recover(dir + "clients.txt"));
+        for (std::size_t i = 0; i < checkpoints * perCheckpoint; ++i) {
+            CHECK(ledger.processTransaction(transfer(i)) == TxStatus::OK);
+            if (i % perCheckpoint == perCheckpoint - 1) {
+                CHECK(manager.checkpoint());
+                CHECK(manager.wait());
+            }
+        }
+    }
+
+    IdArchive archive(dir);
+    CHECK(archive.open());
+    CHECK(archive.getEnd() == checkpoints);
+    CHECK(archive.getIdCount() == checkpoints * perCheckpoint);
+    CHECK(archive.getRunCount() <= 6);
+    CHECK(archive.contains("t0") && archive.contains("t199") && !archive.contains("t200"));
+
+    Blockchain ledger;
+    CheckpointManager manager(ledger, dir, config);
+    CHECK(manager.recover(dir + "clients.txt"));
+    std::size_t duplicates = 0;
+    for (std::size_t i = 0; i < checkpoints * perCheckpoint; ++i)
+        duplicates += ledger.processTransaction(transfer(i)) == TxStatus::DUPLICATE_ID;
+    CHECK(duplicates == checkpoints * perCheckpoint);
+}
+
+static std::size_t countLines(const std::string& filename, const std::string& line) {
+    std::ifstream file(filename);
+    std::size_t count = 0;
+    for (std::string read; std::getline(file, read);)
+        count += read == line;
+    return count;
+}
+
+// A cross-shard transfer whose debit is refused, or whose prepare outlived a crash, moves nothing
+static void testShardedAbortPath() {
+    const std::string dir = scratch("sharded");
+    const std::size_t wallets = 32;
+    std::size_t sender = 0, recipient = 0, other = 0;
+    {
+        ShardedLedger ledger(4, dir);
+        CHECK(ledger.open());
+        CHECK(ledger.addClient("c0", "client", ClientTier::GOLD));
+        for (std::size_t i = 0; i < wallets; ++i)
+            CHECK(ledger.createWallet("c0", walletId(i), money(100)) != nullptr);
+        CHECK(ledger.save());
+        while (ledger.shardOfWallet(walletId(recipient)) == ledger.shardOfWallet(walletId(sender))) recipient++;
+        while (ledger.shardOfWallet(walletId(other)) == ledger.shardOfWallet(walletId(sender)) ||
+               ledger.shardOfWallet(walletId(other)) == ledger.shardOfWallet(walletId(recipient))) other++;
+
+        // Refused debit: aborted, nothing moved, and the ID is not taken
+        CHECK(ledger.processTransaction(Transaction("abort", walletId(sender), walletId(recipient), money(500),
+                                                    TxType::TRANSFER, money(5))) == TxStatus::INSUFFICIENT_FUNDS);
+        CHECK(ledger.findWalletById(walletId(sender))->getBalance() == money(100));
+        CHECK(ledger.findWalletById(walletId(recipient))->getBalance() == money(100));
+        CHECK(countLines(dir + "intents.txt", "A;abort") == 1);
+        CHECK(ledger.processTransaction(Transaction("abort", walletId(sender), walletId(recipient), money(40),
+                                                    TxType::TRANSFER, 0)) == TxStatus::OK);
+        // The ID is now taken on every shard, not only on the two it touched
+        CHECK(ledger.processTransaction(Transaction("abort", walletId(other), walletId(other), money(1),
+                                                    TxType::TRANSFER, 0)) == TxStatus::DUPLICATE_ID);
+    }
+
+    // Crash after the prepare record, before the debit: open() aborts it
+    {
+        std::ofstream intents(dir + "intents.txt", std::ios::app);
+        intents << "P;crashed;" << walletId(sender) << ";" << walletId(recipient) << ";10.00;0.00;0\n";
+    }
+    for (int round = 0; round < 2; ++round) {
+        ShardedLedger ledger(4, dir);
+        CHECK(ledger.open());
+        CHECK(ledger.findWalletById(walletId(sender))->getBalance() == money(60));
+        CHECK(ledger.findWalletById(walletId(recipient))->getBalance() == money(140));
+        CHECK(countLines(dir + "intents.txt", "A;crashed") == 1);
+        CHECK(ledger.processTransaction(Transaction("abort", walletId(other), walletId(sender), money(1),
+                                                    TxType::TRANSFER, 0)) == TxStatus::DUPLICATE_ID);
+    }
+}
+
+// Crash after the debit, before the credit: open() rolls the transfer forward, exactly once
+static void testShardedRollForward() {
+    const std::string dir = scratch("rollforward");
+    std::size_t sender = 0, recipient = 0, from = 0;
+    {
+        ShardedLedger ledger(4, dir);
+        CHECK(ledger.open());
+        CHECK(ledger.addClient("c0", "client", ClientTier::GOLD));
+        for (std::size_t i = 0; i < 8; ++i)
+            CHECK(ledger.createWallet("c0", walletId(i), money(100)) != nullptr);
+        CHECK(ledger.save());
+        while (ledger.shardOfWallet(walletId(recipient)) == ledger.shardOfWallet(walletId(sender))) recipient++;
+        from = ledger.shardOfWallet(walletId(sender));
+    }
+    {
+        Timestamp now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        Transaction transfer("roll", walletId(sender), walletId(recipient), money(10), TxType::TRANSFER, money(1), now);
+        std::ofstream(dir + "intents.txt", std::ios::app) << "P;" << formatTransactionRecord(transfer) << "\n";
+        transfer.setType(TxType::DEBIT);
+        std::ofstream(dir + "shard" + std::to_string(from) + "_wal.txt", std::ios::app)
+            << formatTransactionRecord(transfer) << "\n";
+    }
+    for (int round = 0; round < 2; ++round) {
+        ShardedLedger ledger(4, dir);
+        CHECK(ledger.open());
+        CHECK(ledger.findWalletById(walletId(sender))->getBalance() == money(89));
+        CHECK(ledger.findWalletById(walletId(recipient))->getBalance() == money(110));
+        CHECK(countLines(dir + "intents.txt", "C;roll") == 1);
+        CHECK(ledger.processTransaction(Transaction("roll", walletId(recipient), walletId(sender), money(1),
+                                                    TxType::TRANSFER, 0)) == TxStatus::DUPLICATE_ID);
+    }
+}
+
+// A batch gives the result of committing its transfers one by one, whatever shards they touch
+static void testShardedBatchKeepsOrder() {
+    const std::string dir = scratch("sharded_order");
+    const std::size_t wallets = 64;
+    writeBook(dir + "clients.txt", 8, wallets, money(50), 16);
+    ShardedLedger batched(4, dir + "batched_"), serial(4, dir + "serial_");
+    CHECK(batched.open() && serial.open());
+    CHECK(batched.loadClientsFromFile(dir + "clients.txt") && serial.loadClientsFromFile(dir + "clients.txt"));
+
+    std::vector<Transaction> transfers = randomTransfers("s", 2000, wallets, 4);
+    std::vector<Transaction*> batch;
+    for (const Transaction& tx : transfers)
+        batch.push_back(new Transaction(tx));
+    std::vector<TxStatus> statuses = batched.processTransactions(batch.data(), batch.size());
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (statuses[i] != TxStatus::OK) delete batch[i];
+    }
+    std::vector<TxStatus> expected;
+    for (const Transaction& tx : transfers)
+        expected.push_back(serial.processTransaction(Transaction(tx)));
+    CHECK(statuses == expected);
+    bool same = true;
+    for (std::size_t w = 0; w < wallets; ++w)
+        same = same && batched.findWalletById(walletId(w))->getBalance() == serial.findWalletById(walletId(w))->getBalance();
+    CHECK(same);
+}
+
+int main() {
+    struct Test {
+        const char* name;
+        void (*run)();
+    };
+    const Test tests[] = {
+        {"sync log replay equals live state", testSyncLogReplay},
+        {"group-commit log replay equals live state", testGroupCommitLogReplay},
+        {"invalid amounts refused", testInvalidAmountsRefused},
+        {"Merkle tree shape and stale blocks", testMerkleTreeShape},
+        {"duplicate wallet IDs refused", testDuplicateWalletRefused},
+        {"checkpoint recovery rejects earlier IDs", testCheckpointRecoveryRejectsEarlierIds},
+        {"ID archive merges its runs", testIdArchiveMergesRuns},
+        {"sharded two-phase abort path", testShardedAbortPath},
+        {"sharded roll-forward after a crash", testShardedRollForward},
+        {"sharded batch keeps input order", testShardedBatchKeepsOrder},
+    };
+
+    int failedTests = 0;
+    for (const Test& test : tests) {
+        int before = failedChecks;
+        test.run();
+        bool ok = failedChecks == before;
+        std::printf("%s %s\n", ok ? "ok  " : "FAIL", test.name);
+        if (!ok) failedTests++;
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "ledger_tests", ec);
+    std::printf("%d of %zu test(s) failed\n", failedTests, sizeof(tests) / sizeof(tests[0]));
+    return failedTests ? 1 : 0;
+}